@@ -0,0 +1,70 @@
+#include "sage/Adjudicator.h"
+
+#ifndef INCLUDED_sage_BoardEvaluator_h
+#include "sage/BoardEvaluator.h"
+#endif
+
+#ifndef INCLUDED_sage_State_h
+#include "sage/State.h"
+#endif
+
+#ifndef INCLUDED_std_cmath
+#include <cmath>
+#define INCLUDED_std_cmath
+#endif
+
+namespace sage {
+
+void Adjudicator::update(Game& game)
+{
+  if (game.getState() != STATE_ongoing)
+  {
+    return;
+  }
+
+  int plies = static_cast<int>(game.getMoveList().size());
+
+  if (m_settings.m_evaluator
+      && ((m_settings.m_resignPlies > 0) || (m_settings.m_drawPlies > 0)))
+  {
+    double score = m_settings.m_evaluator->evaluate(game.getCurrentBoard());
+
+    // any ply that breaks a streak starts it over
+    m_whiteAhead = ((score >= m_settings.m_resignScore)
+                    ? (m_whiteAhead + 1) : 0);
+    m_blackAhead = ((score <= -m_settings.m_resignScore)
+                    ? (m_blackAhead + 1) : 0);
+    // the ply just played is ply number plies (from 1) and belongs to
+    // move (plies + 1) / 2, so it counts once plies > 2 * (m_drawMove - 1)
+    m_level = (((plies > 2 * (m_settings.m_drawMove - 1))
+                && (std::fabs(score) <= m_settings.m_drawScore))
+               ? (m_level + 1) : 0);
+
+    if (m_settings.m_resignPlies > 0)
+    {
+      if (m_whiteAhead >= m_settings.m_resignPlies)
+      {
+        game.setState(STATE_whiteWon, REASON_resignation);
+        return;
+      }
+      if (m_blackAhead >= m_settings.m_resignPlies)
+      {
+        game.setState(STATE_blackWon, REASON_resignation);
+        return;
+      }
+    }
+
+    if ((m_settings.m_drawPlies > 0) && (m_level >= m_settings.m_drawPlies))
+    {
+      game.setState(STATE_draw, REASON_drawAdjudication);
+      return;
+    }
+  }
+
+  if ((m_settings.m_maxPlies > 0) && (plies >= m_settings.m_maxPlies))
+  {
+    game.setState(STATE_draw, REASON_maxPlies);
+  }
+}
+
+} // namespace sage
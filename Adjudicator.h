@@ -0,0 +1,122 @@
+#ifndef INCLUDED_sage_Adjudicator_h
+#define INCLUDED_sage_Adjudicator_h
+
+#ifndef INCLUDED_sage_Game_h
+#include "sage/Game.h"
+#endif
+
+namespace sage {
+
+class BoardEvaluator;
+
+/*!
+  \brief Ends games early by rules that go beyond those of chess
+
+  Games played in bulk (e.g. for fitness evaluation) need to finish within
+  a predictable budget. Each rule is off unless configured:
+
+  - Resignation: the score has favoured one side by at least the resign
+    score for the given number of consecutive plies.
+  - Draw: the score has stayed within the draw score of zero for the given
+    number of consecutive plies, counting only plies from the given move
+    number on.
+  - Ply limit: the game is drawn once it reaches the given number of plies.
+
+  Scores come from a BoardEvaluator, from white's point of view. The rule
+  that ended the game is recorded as the Game's Reason.
+
+  An adjudicator follows one game; the engines call update() after every
+  move.
+*/
+class Adjudicator
+{
+ public:
+
+  //! Settings for ending games early
+  struct Settings
+  {
+    /*!
+      \brief Default constructor: no adjudication
+    */
+    Settings()
+      : m_evaluator(0), m_resignScore(0.9), m_resignPlies(0),
+      m_drawScore(0.05), m_drawPlies(0), m_drawMove(0), m_maxPlies(0)
+    {
+      ;
+    }
+
+    //! Scores positions for the resign and draw rules; 0 disables both
+    BoardEvaluator* m_evaluator;
+
+    //! Absolute score at or beyond which the losing side may resign
+    double m_resignScore;
+
+    //! Consecutive plies beyond m_resignScore to resign; 0 disables
+    int m_resignPlies;
+
+    //! Absolute score at or within which the game may be drawn
+    double m_drawScore;
+
+    //! Consecutive plies within m_drawScore to draw; 0 disables
+    int m_drawPlies;
+
+    //! Move number, counting from 1, whose plies are the first to count
+    //! towards a draw (white's ply of it included); 0 or 1 counts all
+    int m_drawMove;
+
+    //! Plies after which the game is drawn; 0 disables
+    int m_maxPlies;
+  };
+
+  /*!
+    \brief Constructor
+    \param settings The rules to apply. The evaluator, if any, must outlive
+    the adjudicator.
+  */
+  explicit Adjudicator(const Settings& settings)
+    : m_settings(settings), m_whiteAhead(0), m_blackAhead(0), m_level(0)
+  {
+    ;
+  }
+
+  /*!
+    \brief Destructor
+  */
+  virtual ~Adjudicator()
+  {
+    ;
+  }
+
+  /*!
+    \brief Returns the rules being applied
+  */
+  const Settings& getSettings() const { return m_settings; }
+
+  /*!
+    \brief Applies the rules after a move
+    \param game [inout] The game; its state is set if a rule ends it
+
+    Does nothing if the game is already over.
+  */
+  void update(Game& game);
+
+ private:
+  // Default constructor not defined
+  Adjudicator();
+
+  //! The rules being applied
+  Settings m_settings;
+
+  //! Consecutive plies with white at or beyond the resign score
+  int m_whiteAhead;
+
+  //! Consecutive plies with black at or beyond the resign score
+  int m_blackAhead;
+
+  //! Consecutive counted plies within the draw score
+  int m_level;
+};
+
+} // namespace sage
+
+#endif
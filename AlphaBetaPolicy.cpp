@@ -0,0 +1,733 @@
+#include "sage/AlphaBetaPolicy.h"
+
+#ifndef INCLUDED_sage_BoardEvaluator_h
+#include "sage/BoardEvaluator.h"
+#endif
+
+#ifndef INCLUDED_sage_BoardUtil_h
+#include "sage/BoardUtil.h"
+#endif
+
+#ifndef INCLUDED_sage_Material_h
+#include "sage/Material.h"
+#endif
+
+#ifndef INCLUDED_sage_MovePicker_h
+#include "sage/MovePicker.h"
+#endif
+
+#ifndef INCLUDED_sage_ThreadPool_h
+#include "sage/ThreadPool.h"
+#endif
+
+#ifndef INCLUDED_sage_TranspositionTable_h
+#include "sage/TranspositionTable.h"
+#endif
+
+#ifndef INCLUDED_std_algorithm
+#include <algorithm>
+#define INCLUDED_std_algorithm
+#endif
+
+#ifndef INCLUDED_std_cmath
+#include <cmath>
+#define INCLUDED_std_cmath
+#endif
+
+#ifndef INCLUDED_std_exception
+#include <exception>
+#define INCLUDED_std_exception
+#endif
+
+#ifndef INCLUDED_std_memory
+#include <memory>
+#define INCLUDED_std_memory
+#endif
+
+#ifndef INCLUDED_std_vector
+#include <vector>
+#endif
+
+namespace sage {
+
+namespace {
+
+  //! Score for checkmating; above any evaluation
+  const double WIN_SCORE = 2.0;
+
+  //! Taken off a mate score per ply, so that sooner mates score higher
+  const double MATE_STEP = 0.001;
+
+  //! Bound beyond any score
+  const double INFINITE_SCORE = 3.0;
+
+  //! Scores beyond this are mates
+  const double MATE_BOUND = 1.5;
+
+  //! Nodes between looks at the clock
+  const uint64_t TIME_CHECK_NODES = 1024;
+
+  //! Halfmoves without progress that draw
+  const int FIFTY_MOVE_LIMIT = 100;
+
+  //! Centipawns beyond the captured piece that a capture in the
+  //! quiescence search is allowed for positional gains before it is
+  //! pruned
+  const int DELTA_MARGIN = 200;
+
+  //! Table score units per unit of score
+  const double TABLE_SCALE = 10000.0;
+
+  //! Stored for positions whose best move is not known
+  const PackedMove NO_MOVE(0, 0, PackedMove::FLAG_quiet);
+
+  /*!
+    \brief Converts a score for the transposition table
+    \param score The score
+    \param ply Plies from the root to the position
+
+    Mate scores count plies from the root; in the table they count from
+    the position, so that they hold wherever it is met again.
+  */
+  int toTable(double score, int ply)
+  {
+    if (score > MATE_BOUND)
+    {
+      score += ply * MATE_STEP;
+    }
+    else if (score < -MATE_BOUND)
+    {
+      score -= ply * MATE_STEP;
+    }
+
+    return static_cast<int>(std::lround(score * TABLE_SCALE));
+  }
+
+  /*!
+    \brief Converts a score from the transposition table
+    \param value The stored score
+    \param ply Plies from the root to the position
+  */
+  double fromTable(int value, int ply)
+  {
+    double score = value / TABLE_SCALE;
+    if (score > MATE_BOUND)
+    {
+      score -= ply * MATE_STEP;
+    }
+    else if (score < -MATE_BOUND)
+    {
+      score += ply * MATE_STEP;
+    }
+
+    return score;
+  }
+
+} // anonymous namespace
+
+/*!
+  \brief One thread's search of the root
+
+  Each thread has its own board and searched line; they share only the
+  policy's settings, stop flag and transposition table.
+*/
+class AlphaBetaPolicy::Searcher
+{
+ public:
+
+  /*!
+    \brief Constructor
+    \param policy The policy searching
+    \param board The root position
+    \param moves The root moves, in the order of the policy's MoveList
+    \param id 0 for the calling thread, 1 and up for the helpers
+  */
+  Searcher(AlphaBetaPolicy& policy, const Board& board,
+           const PackedMoveList& moves, int id)
+    : m_policy(policy), m_board(board), m_path(), m_moves(moves),
+      m_order(moves.size()), m_history(), m_id(id), m_depth(0),
+      m_score(0.0), m_nodes(0), m_error()
+  {
+    const int count = static_cast<int>(m_moves.size());
+
+    // helpers start on different root moves, to spread the threads out
+    for (int i = 0; i < count; ++i)
+    {
+      m_order[i] = (i + id) % count;
+    }
+
+    m_path.push_back(m_board.getHash());
+  }
+
+  /*!
+    \brief Runs the search, keeping any exception for the policy to
+    rethrow on the calling thread
+  */
+  void runSafely()
+  {
+    try
+    {
+      run();
+    }
+    catch (...)
+    {
+      m_error = std::current_exception();
+      m_policy.m_stop.store(true);
+    }
+  }
+
+  /*!
+    \brief Returns the index of the best move found in the policy's
+    MoveList
+  */
+  int getBest() const { return m_order[0]; }
+
+  /*!
+    \brief Returns the deepest iteration finished
+  */
+  int getDepth() const { return m_depth; }
+
+  /*!
+    \brief Returns the score of the best move found
+  */
+  double getScore() const { return m_score; }
+
+  /*!
+    \brief Returns the nodes visited
+  */
+  uint64_t getNodes() const { return m_nodes; }
+
+  /*!
+    \brief Returns the exception the search ended with, if any
+  */
+  const std::exception_ptr& getError() const { return m_error; }
+
+ private:
+
+  /*!
+    \brief Deepens the search until the depth limit or the stop flag
+  */
+  void run();
+
+  /*!
+    \brief Searches the current position
+    \param depth Plies left to search
+    \param ply Plies from the root
+    \param alpha Score the side to move is already sure of
+    \param beta Score at which the opponent avoids this position
+    \return The score from the point of view of the side to move; not
+    meaningful once the search has been stopped
+  */
+  double search(int depth, int ply, double alpha, double beta);
+
+  /*!
+    \brief Searches the captures and promotions of the current position
+    until it is quiet
+    \param ply Plies from the root
+    \param alpha Score the side to move is already sure of
+    \param beta Score at which the opponent avoids this position
+    \return The score from the point of view of the side to move; not
+    meaningful once the search has been stopped
+  */
+  double quiesce(int ply, double alpha, double beta);
+
+  /*!
+    \brief Records the position just moved to on the searched line and
+    starts loading its transposition table entry
+  */
+  void enter();
+
+  /*!
+    \brief Scores the current position with the evaluator
+    \return The score from the point of view of the side to move
+  */
+  double evaluate();
+
+  /*!
+    \brief Returns whether the current position is a draw by the fifty
+    move rule, lack of material or repetition
+  */
+  bool isDraw() const;
+
+  /*!
+    \brief Returns whether the current position repeats one earlier on
+    the searched line
+  */
+  bool isRepetition() const;
+
+  /*!
+    \brief Counts a node; the calling thread also stops the search if the
+    budget is spent
+    \retval true If the search should carry on
+    \retval false If it has been stopped
+  */
+  bool countNode();
+
+  //! The policy searching
+  AlphaBetaPolicy& m_policy;
+
+  //! The board being searched
+  Board m_board;
+
+  //! Hashes of the positions on the searched line, the current one last
+  std::vector<HashKey> m_path;
+
+  //! The root moves
+  const PackedMoveList& m_moves;
+
+  //! Indices of the root moves in the order to try them, best first
+  std::vector<int> m_order;
+
+  //! Killers and history for ordering quiet moves
+  MoveHistory m_history;
+
+  //! 0 for the calling thread, 1 and up for the helpers
+  int m_id;
+
+  //! Deepest iteration finished
+  int m_depth;
+
+  //! Score of the best move found
+  double m_score;
+
+  //! Nodes visited
+  uint64_t m_nodes;
+
+  //! The exception the search ended with, if any
+  std::exception_ptr m_error;
+};
+
+void AlphaBetaPolicy::Searcher::run()
+{
+  const Settings& settings = m_policy.m_settings;
+  const int count = static_cast<int>(m_moves.size());
+
+  // every other helper keeps one ply ahead
+  for (int depth = 1 + (m_id & 1); depth <= settings.m_maxDepth; ++depth)
+  {
+    double alpha = -INFINITE_SCORE;
+    int best = -1;
+
+    for (int i = 0; i < count; ++i)
+    {
+      Board::Undo undo;
+      m_board.makeMove(m_moves[m_order[i]], undo);
+      enter();
+      double score = -search(depth - 1, 1, -INFINITE_SCORE, -alpha);
+      m_path.pop_back();
+      m_board.unmakeMove(m_moves[m_order[i]], undo);
+
+      if (m_policy.m_stop.load(std::memory_order_relaxed))
+      {
+        break;
+      }
+
+      if (score > alpha)
+      {
+        alpha = score;
+        best = i;
+      }
+    }
+
+    // an unfinished iteration still searched the previous best move first,
+    // so any move that beat it is the better choice
+    if (best >= 0)
+    {
+      std::rotate(m_order.begin(), m_order.begin() + best,
+                  m_order.begin() + best + 1);
+      m_score = alpha;
+    }
+
+    if (m_policy.m_stop.load(std::memory_order_relaxed))
+    {
+      break;
+    }
+
+    m_depth = depth;
+
+    // a forced mate either way will not change with more depth, and an
+    // iteration that starts after half the time rarely finishes
+    if ((m_id == 0)
+        && ((alpha > MATE_BOUND) || (alpha < -MATE_BOUND)
+            || ((settings.m_maxMilliseconds > 0)
+                && (2 * m_policy.m_timer.getElapsedMilliseconds()
+                    >= settings.m_maxMilliseconds))))
+    {
+      break;
+    }
+  }
+}
+
+double AlphaBetaPolicy::Searcher::search(int depth, int ply, double alpha,
+                                         double beta)
+{
+  if (depth <= 0)
+  {
+    return quiesce(ply, alpha, beta);
+  }
+
+  if (!countNode())
+  {
+    return 0.0;
+  }
+
+  if (isDraw())
+  {
+    return 0.0;
+  }
+
+  TranspositionTable* const table = m_policy.m_settings.m_table;
+  const HashKey hash = m_path.back();
+  PackedMove hashMove = NO_MOVE;
+  TranspositionTable::Entry entry;
+
+  if (table && table->probe(hash, entry))
+  {
+    if (entry.hasMove())
+    {
+      hashMove = entry.getMove();
+    }
+
+    if (entry.getDepth() >= depth)
+    {
+      double score = fromTable(entry.getScore(), ply);
+      if ((entry.getBound() == TranspositionTable::BOUND_exact)
+          || ((entry.getBound() == TranspositionTable::BOUND_lower)
+              && (score >= beta))
+          || ((entry.getBound() == TranspositionTable::BOUND_upper)
+              && (score <= alpha)))
+      {
+        return score;
+      }
+    }
+  }
+
+  // moves come best first: the stored move, then captures, then quiet
+  // moves by how often they have cut off elsewhere
+  MovePicker picker(m_board, hashMove, m_history, ply);
+  MoveBuffer<> quiets;
+  PackedMove move;
+  PackedMove bestMove = NO_MOVE;
+  const double originalAlpha = alpha;
+  double best = -INFINITE_SCORE;
+
+  while (picker.next(move))
+  {
+    Board::Undo undo;
+    m_board.makeMove(move, undo);
+    enter();
+    double score = -search(depth - 1, ply + 1, -beta, -alpha);
+    m_path.pop_back();
+    m_board.unmakeMove(move, undo);
+
+    if (m_policy.m_stop.load(std::memory_order_relaxed))
+    {
+      return 0.0;
+    }
+
+    if (score > best)
+    {
+      best = score;
+      bestMove = move;
+      if (score > alpha)
+      {
+        alpha = score;
+        if (alpha >= beta)
+        {
+          if (!move.isTactical())
+          {
+            m_history.update(Board::getColorIndex(m_board.getTurn()), ply,
+                             depth, move, quiets);
+          }
+          break;
+        }
+      }
+    }
+
+    if (!move.isTactical())
+    {
+      quiets.push_back(move);
+    }
+  }
+
+  if (bestMove == NO_MOVE)
+  {
+    return (BoardUtil::inCheck(m_board, m_board.getTurn())
+            ? (-WIN_SCORE + (ply * MATE_STEP))
+            : 0.0);
+  }
+
+  if (table)
+  {
+    // failing low says nothing about which move is best
+    TranspositionTable::Bound bound = ((best >= beta)
+                                       ? TranspositionTable::BOUND_lower
+                                       : ((best > originalAlpha)
+                                          ? TranspositionTable::BOUND_exact
+                                          : TranspositionTable::BOUND_upper));
+    table->store(hash,
+                 ((bound == TranspositionTable::BOUND_upper)
+                  ? NO_MOVE : bestMove),
+                 toTable(best, ply), depth, bound);
+  }
+
+  return best;
+}
+
+double AlphaBetaPolicy::Searcher::quiesce(int ply, double alpha,
+                                           double beta)
+{
+  if (!countNode())
+  {
+    return 0.0;
+  }
+
+  if (isDraw())
+  {
+    return 0.0;
+  }
+
+  // the side to move need not capture, so it scores at least the position
+  // as it stands (stand pat). in check that is not so; checks are left to
+  // the main search
+  const double standPat = evaluate();
+  if (standPat >= beta)
+  {
+    return standPat;
+  }
+  alpha = std::max(alpha, standPat);
+
+  // the picker leaves out captures that lose material
+  const double pawnScore = m_policy.m_settings.m_pawnScore;
+  MovePicker picker(m_board);
+  PackedMove move;
+  double best = standPat;
+
+  while (picker.next(move))
+  {
+    // delta pruning: skip a capture that cannot bring the score up to
+    // alpha even with a margin for what else it changes
+    if ((pawnScore > 0.0) && !move.isPromotion())
+    {
+      int gain = (move.isEnPassant()
+                  ? BoardUtil::getPieceValue(Piece::PIECE_whitePawn)
+                  : BoardUtil::getPieceValue(
+                    m_board.getPieceType(move.getTo())));
+      if (standPat + (((gain + DELTA_MARGIN) * pawnScore)
+                      / BoardUtil::getPieceValue(Piece::PIECE_whitePawn))
+          <= alpha)
+      {
+        continue;
+      }
+    }
+
+    Board::Undo undo;
+    m_board.makeMove(move, undo);
+    enter();
+    double score = -quiesce(ply + 1, -beta, -alpha);
+    m_path.pop_back();
+    m_board.unmakeMove(move, undo);
+
+    if (m_policy.m_stop.load(std::memory_order_relaxed))
+    {
+      return 0.0;
+    }
+
+    if (score > best)
+    {
+      best = score;
+      if (score > alpha)
+      {
+        alpha = score;
+        if (alpha >= beta)
+        {
+          break;
+        }
+      }
+    }
+  }
+
+  return best;
+}
+
+void AlphaBetaPolicy::Searcher::enter()
+{
+  const HashKey hash = m_board.getHash();
+  if (m_policy.m_settings.m_table)
+  {
+    m_policy.m_settings.m_table->prefetch(hash);
+  }
+
+  m_path.push_back(hash);
+}
+
+double AlphaBetaPolicy::Searcher::evaluate()
+{
+  double score = m_policy.m_evaluator.evaluate(m_board);
+  return ((m_board.getTurn() == Board::COLOR_white) ? score : -score);
+}
+
+bool AlphaBetaPolicy::Searcher::isDraw() const
+{
+  return ((m_board.getHalfmoveClock() >= FIFTY_MOVE_LIMIT)
+          || Material::isDeadDraw(m_board.getMaterialKey())
+          || isRepetition());
+}
+
+bool AlphaBetaPolicy::Searcher::isRepetition() const
+{
+  // only positions since the last capture or pawn move, with the same side
+  // to move, can repeat; the nearest is four plies back
+  const size_t last = m_path.size() - 1;
+  const size_t clock = m_board.getHalfmoveClock();
+
+  for (size_t back = 4; (back <= clock) && (back <= last); back += 2)
+  {
+    if (m_path[last - back] == m_path[last])
+    {
+      return true;
+    }
+  }
+
+  return false;
+}
+
+bool AlphaBetaPolicy::Searcher::countNode()
+{
+  ++m_nodes;
+
+  // the budget is the calling thread's; the helpers stop when it does
+  const Settings& settings = m_policy.m_settings;
+  if ((m_id == 0)
+      && (((settings.m_maxNodes > 0) && (m_nodes >= settings.m_maxNodes))
+          || ((settings.m_maxMilliseconds > 0)
+              && ((m_nodes % TIME_CHECK_NODES) == 0)
+              && (m_policy.m_timer.getElapsedMilliseconds()
+                  >= settings.m_maxMilliseconds))))
+  {
+    m_policy.m_stop.store(true, std::memory_order_relaxed);
+  }
+
+  return !m_policy.m_stop.load(std::memory_order_relaxed);
+}
+
+AlphaBetaPolicy::AlphaBetaPolicy(BoardEvaluator& evaluator,
+                                 const Settings& settings)
+  : m_evaluator(evaluator), m_settings(settings), m_timer(),
+    m_ownPool(((settings.m_threads > 1) && !settings.m_pool)
+              ? new ThreadPool(settings.m_threads - 1) : 0),
+    m_pool((settings.m_threads > 1)
+           ? (settings.m_pool ? settings.m_pool : m_ownPool.get()) : 0),
+    m_stop(false), m_depth(0), m_score(0.0), m_nodes(0), m_totalNodes(0),
+    m_totalSeconds(0.0)
+{
+
+}
+
+AlphaBetaPolicy::~AlphaBetaPolicy()
+{
+
+}
+
+int AlphaBetaPolicy::decide(const Board& board, const MoveList& moveList)
+{
+  const int count = static_cast<int>(moveList.size());
+
+  m_timer.reset();
+  m_stop.store(false);
+  m_depth = 0;
+  m_score = 0.0;
+  m_nodes = 0;
+
+  if (count <= 1)
+  {
+    return 0;
+  }
+
+  if (m_settings.m_table)
+  {
+    m_settings.m_table->newSearch();
+  }
+
+  PackedMoveList moves(count);
+  for (int i = 0; i < count; ++i)
+  {
+    moves[i] = PackedMove::fromMove(moveList[i]);
+  }
+
+  const int threads = (m_pool ? m_settings.m_threads : 1);
+  std::vector<std::unique_ptr<Searcher> > searchers;
+  for (int id = 0; id < threads; ++id)
+  {
+    searchers.emplace_back(new Searcher(*this, board, moves, id));
+  }
+
+  ThreadPool::TaskGroup helpers;
+  for (int id = 1; id < threads; ++id)
+  {
+    Searcher* searcher = searchers[id].get();
+    m_pool->submit(helpers, [searcher]() { searcher->runSafely(); });
+  }
+
+  searchers[0]->runSafely();
+
+  // a helper the pool has not started yet runs here and stops at once; so
+  // may a helper of another policy sharing the pool
+  m_stop.store(true);
+  if (m_pool)
+  {
+    m_pool->wait(helpers);
+  }
+
+  for (int id = 0; id < threads; ++id)
+  {
+    if (searchers[id]->getError())
+    {
+      std::rethrow_exception(searchers[id]->getError());
+    }
+  }
+
+  // the deepest finished iteration is the most reliable; the calling
+  // thread wins ties
+  const Searcher* chosen = searchers[0].get();
+  for (int id = 0; id < threads; ++id)
+  {
+    m_nodes += searchers[id]->getNodes();
+    if (searchers[id]->getDepth() > chosen->getDepth())
+    {
+      chosen = searchers[id].get();
+    }
+  }
+
+  m_depth = chosen->getDepth();
+  m_score = chosen->getScore();
+  m_totalNodes += m_nodes;
+  m_totalSeconds += m_timer.getElapsedSeconds();
+  return chosen->getBest();
+}
+
+AlphaBetaPolicyFactory::AlphaBetaPolicyFactory(
+  BoardEvaluator& evaluator,
+  const AlphaBetaPolicy::Settings& settings)
+  : m_evaluator(evaluator), m_settings(settings),
+    m_pool(((settings.m_threads > 1) && !settings.m_pool)
+           ? new ThreadPool(settings.m_threads - 1) : 0)
+{
+  if (m_pool)
+  {
+    m_settings.m_pool = m_pool.get();
+  }
+}
+
+AlphaBetaPolicyFactory::~AlphaBetaPolicyFactory()
+{
+
+}
+
+std::unique_ptr<Policy> AlphaBetaPolicyFactory::create(uint64_t seed) const
+{
+  return std::unique_ptr<Policy>(new AlphaBetaPolicy(m_evaluator,
+                                                     m_settings));
+}
+
+} // namespace sage
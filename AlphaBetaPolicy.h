@@ -0,0 +1,290 @@
+#ifndef INCLUDED_sage_AlphaBetaPolicy_h
+#define INCLUDED_sage_AlphaBetaPolicy_h
+
+#ifndef INCLUDED_sage_Policy_h
+#include "sage/Policy.h"
+#endif
+
+#ifndef INCLUDED_sage_PackedMove_h
+#include "sage/PackedMove.h"
+#endif
+
+#ifndef INCLUDED_sage_PolicyFactory_h
+#include "sage/PolicyFactory.h"
+#endif
+
+#ifndef INCLUDED_sage_Timer_h
+#include "sage/Timer.h"
+#endif
+
+#ifndef INCLUDED_std_atomic
+#include <atomic>
+#define INCLUDED_std_atomic
+#endif
+
+#ifndef INCLUDED_std_memory
+#include <memory>
+#define INCLUDED_std_memory
+#endif
+
+#ifndef INCLUDED_std_stdint
+#include <stdint.h>
+#define INCLUDED_std_stdint
+#endif
+
+namespace sage {
+
+class BoardEvaluator;
+class ThreadPool;
+class TranspositionTable;
+
+/*!
+  \brief Chess policy that searches ahead with alpha-beta
+
+  The search is a negamax alpha-beta search, deepened one ply at a time
+  until the budget runs out. Each iteration tries the best move of the
+  previous one first, which makes the cutoffs of the next much cheaper.
+  When the budget runs out partway through an iteration, a move that beat
+  the previous best in it is still taken.
+
+  At the end of each line, a quiescence search plays out the captures and
+  promotions until the position is quiet, so that a leaf is not scored in
+  the middle of an exchange. At each of its positions the side to move
+  may instead stand pat, i.e. take the evaluation as it stands. Captures
+  and promotions that lose material by BoardUtil::getExchangeValue() are
+  not searched, nor are promotions to anything but a queen.
+  Given the score of a pawn, captures that cannot raise the score to
+  alpha even with a margin are not searched either (delta pruning). The
+  quiescence search does not look at checks, so a position in check is
+  scored as if the side to move could pass.
+
+  Positions are scored with a BoardEvaluator. Its scores are from white's
+  point of view and are negated for black. Checkmate scores beyond any
+  evaluation, sooner mates scoring higher; stalemate, dead positions,
+  the fifty-move rule and positions repeated along the searched line
+  score as draws. Repetitions of positions before the search are not
+  seen, since the policy only gets the board.
+
+  Given a TranspositionTable, the search stores the score and best move
+  of each position it finishes, and uses them to cut the search short or
+  to try that move first when it meets the position again. A table may be
+  shared by any number of policies on any threads, as long as they use
+  the same evaluator.
+
+  The search can run on several threads in the manner of Lazy SMP. The
+  helper threads search the same root as the calling thread, with no
+  coordination beyond the shared table: they start one ply deeper every
+  other thread and try the root moves in a rotated order, so that they
+  fill the table with results the others are about to need. Every thread
+  stops when the calling thread does. The move chosen comes from whichever
+  thread finished the deepest iteration. With more than one thread the
+  evaluator must be safe to call from several threads at once, and
+  without a table the helpers only waste time. The helpers run on a
+  ThreadPool that is started once, so no threads are started per move:
+  either the one named in the settings, which any number of policies may
+  share, or one that the policy starts itself and keeps.
+
+  The policy keeps the node count and time of every search so that its
+  speed can be reported.
+*/
+class AlphaBetaPolicy : public Policy
+{
+ public:
+
+  //! Limits on each search
+  struct Settings
+  {
+    /*!
+      \brief Default constructor: a small node budget
+    */
+    Settings()
+      : m_maxDepth(DEFAULT_DEPTH), m_maxNodes(DEFAULT_NODES),
+      m_maxMilliseconds(0), m_table(0), m_threads(1), m_pool(0),
+      m_pawnScore(0.0)
+    {
+      ;
+    }
+
+    //! Deepest iteration to search, in plies
+    int m_maxDepth;
+
+    //! Nodes of the calling thread after which the search stops; 0 for no
+    //! limit
+    uint64_t m_maxNodes;
+
+    //! Milliseconds after which the search stops; 0 for no limit
+    long m_maxMilliseconds;
+
+    //! Caches results between positions and searches; 0 for none. It must
+    //! outlive the policy.
+    TranspositionTable* m_table;
+
+    //! Threads to search with, including the calling thread
+    int m_threads;
+
+    //! Runs the helper searches; 0 for the policy to start its own. It
+    //! may be shared by any number of policies and must outlive them.
+    ThreadPool* m_pool;
+
+    //! What a pawn is worth to the evaluator, for delta pruning in the
+    //! quiescence search; 0 to not prune
+    double m_pawnScore;
+  };
+
+  //! Constants used by the search
+  enum Constant
+  {
+    DEFAULT_DEPTH = 64,   //!< Default deepest iteration
+    DEFAULT_NODES = 20000 //!< Default node budget
+  };
+
+  /*!
+    \brief Constructor
+    \param evaluator Scores the positions; it must outlive the policy. It
+    is only called while the policy decides, but with more than one thread
+    in the settings it is called from every search thread at once
+    \param settings The limits on each search
+  */
+  explicit AlphaBetaPolicy(BoardEvaluator& evaluator,
+                           const Settings& settings = Settings());
+
+  /*!
+    \brief Destructor
+  */
+  virtual ~AlphaBetaPolicy();
+
+  virtual int decide(const Board& board, const MoveList& moveList);
+
+  /*!
+    \brief Returns the limits on each search
+  */
+  const Settings& getSettings() const { return m_settings; }
+
+  /*!
+    \brief Returns the deepest iteration finished by the last search
+  */
+  int getDepth() const { return m_depth; }
+
+  /*!
+    \brief Returns the score of the move chosen by the last search
+    \return The score, from the point of view of the side that moved
+  */
+  double getScore() const { return m_score; }
+
+  /*!
+    \brief Returns the nodes visited by the last search, over all threads
+  */
+  uint64_t getNodes() const { return m_nodes; }
+
+  /*!
+    \brief Returns the nodes visited by every search so far
+  */
+  uint64_t getTotalNodes() const { return m_totalNodes; }
+
+  /*!
+    \brief Returns the seconds spent in every search so far
+  */
+  double getTotalSeconds() const { return m_totalSeconds; }
+
+  /*!
+    \brief Returns the nodes searched per second over every search so far
+    \return The rate; 0 if nothing has been timed yet
+  */
+  double getNodesPerSecond() const
+  {
+    return ((m_totalSeconds > 0.0) ? (m_totalNodes / m_totalSeconds) : 0.0);
+  }
+
+ private:
+  // Default constructor not defined
+  AlphaBetaPolicy();
+
+  //! One thread's search; defined with the policy's implementation
+  class Searcher;
+
+  //! Scores the leaves
+  BoardEvaluator& m_evaluator;
+
+  //! The limits on each search
+  Settings m_settings;
+
+  //! Times the search
+  Timer m_timer;
+
+  //! The pool the policy started, if the settings named none; null with
+  //! one thread
+  std::unique_ptr<ThreadPool> m_ownPool;
+
+  //! Runs the helper searches; null with one thread
+  ThreadPool* m_pool;
+
+  //! Set to stop every thread of the search
+  std::atomic<bool> m_stop;
+
+  //! Deepest iteration finished by the last search
+  int m_depth;
+
+  //! Score of the move chosen by the last search
+  double m_score;
+
+  //! Nodes visited by the last search, over all threads
+  uint64_t m_nodes;
+
+  //! Nodes visited by every search
+  uint64_t m_totalNodes;
+
+  //! Seconds spent in every search
+  double m_totalSeconds;
+};
+
+/*!
+  \brief Factory for AlphaBetaPolicy players, e.g. in a Tournament
+
+  Every policy shares the factory's evaluator and settings (and so any
+  table they name). Games run on many threads at once, so the evaluator
+  must be safe to call from several threads. The seed is ignored, since
+  the search is deterministic.
+
+  With more than one thread in the settings, and no pool named there, the
+  factory starts one ThreadPool and every policy runs its helper searches
+  on it. The helpers of all the games at once then share those threads,
+  instead of each game starting threads of its own.
+*/
+class AlphaBetaPolicyFactory : public PolicyFactory
+{
+ public:
+
+  /*!
+    \brief Constructor
+    \param evaluator Scores the positions; it must outlive the factory and
+    every policy it creates
+    \param settings The limits on each search
+  */
+  explicit AlphaBetaPolicyFactory(
+    BoardEvaluator& evaluator,
+    const AlphaBetaPolicy::Settings& settings = AlphaBetaPolicy::Settings());
+
+  /*!
+    \brief Destructor: the policies created must be gone by now
+  */
+  virtual ~AlphaBetaPolicyFactory();
+
+  virtual std::unique_ptr<Policy> create(uint64_t seed) const;
+
+ private:
+  // Default constructor not defined
+  AlphaBetaPolicyFactory();
+
+  //! Scores the positions for every policy
+  BoardEvaluator& m_evaluator;
+
+  //! The limits on each search, naming the shared pool if any
+  AlphaBetaPolicy::Settings m_settings;
+
+  //! The pool the factory started for its policies; null if none
+  std::unique_ptr<ThreadPool> m_pool;
+};
+
+} // namespace sage
+
+#endif
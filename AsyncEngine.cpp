@@ -0,0 +1,47 @@
+#include "sage/AsyncEngine.h"
+
+#ifndef INCLUDED_sage_Exception_h
+#include "sage/Exception.h"
+#endif
+
+#ifndef INCLUDED_sage_State_h
+#include "sage/State.h"
+#endif
+
+namespace sage {
+
+Task<void> AsyncEngine::run()
+{
+  m_sink->record(GameEvent::makeStart(m_gameId));
+
+  while (m_game.getState() == STATE_ongoing)
+  {
+    // the game already worked out the legal moves when it updated its state
+    const MoveList& moveList = m_game.getLegalMoves();
+    AsyncPolicy& policy = ((m_game.getCurrentBoard().getTurn()
+                            == Board::COLOR_white)
+                           ? m_white
+                           : m_black);
+
+    int moveNum = co_await policy.decide(m_game.getCurrentBoard(), moveList);
+
+    if ((moveNum >= (int) moveList.size()) || (moveNum < 0))
+    {
+      throw InvalidMoveException("Move number out of range");
+    }
+
+    // apply the move; taken first since making it replaces the legal moves
+    PackedMove move = m_game.getLegalMove(moveNum);
+    int ply = static_cast<int>(m_game.getMoveList().size());
+    m_game.applyLegalMove(moveNum);
+    m_sink->record(GameEvent::makeMove(m_gameId, ply, move, moveNum));
+
+    m_adjudicator.update(m_game);
+  }
+
+  m_sink->record(GameEvent::makeEnd(
+                   m_gameId, static_cast<int>(m_game.getMoveList().size()),
+                   m_game.getState(), m_game.getReason()));
+}
+
+} // namespace sage
@@ -0,0 +1,120 @@
+#ifndef INCLUDED_sage_AsyncEngine_h
+#define INCLUDED_sage_AsyncEngine_h
+
+#ifndef INCLUDED_sage_Adjudicator_h
+#include "sage/Adjudicator.h"
+#endif
+
+#ifndef INCLUDED_sage_AsyncPolicy_h
+#include "sage/AsyncPolicy.h"
+#endif
+
+#ifndef INCLUDED_sage_Board_h
+#include "sage/Board.h"
+#endif
+
+#ifndef INCLUDED_sage_GameEvent_h
+#include "sage/GameEvent.h"
+#endif
+
+#ifndef INCLUDED_sage_Game_h
+#include "sage/Game.h"
+#endif
+
+#ifndef INCLUDED_sage_Task_h
+#include "sage/Task.h"
+#endif
+
+namespace sage {
+
+/*!
+  \brief Plays a game between two coroutine policies
+
+  This is the coroutine form of Engine. run() returns a task that suspends
+  whenever a policy does, so a GameScheduler can interleave thousands of
+  games on one thread and let their policies share batched work. Games
+  are adjudicated and report their events just as with Engine.
+*/
+class AsyncEngine
+{
+ public:
+
+  //! Settings for ending games early
+  typedef Adjudicator::Settings Adjudication;
+
+  /*!
+    \brief Constructor: Build game engine with given policies and start
+    position
+    \param white The policy to use for white
+    \param black The policy to use for black
+    \param board The starting position
+    \param adjudication Rules for ending the game early; none by default
+  */
+  AsyncEngine(AsyncPolicy& white, AsyncPolicy& black, const Board& board,
+              const Adjudication& adjudication = Adjudication())
+    : m_white(white), m_black(black), m_game(board),
+    m_adjudicator(adjudication), m_sink(&NullEventSink::getInstance()),
+    m_gameId(0)
+  {
+    ;
+  }
+
+  /*!
+    \brief Destructor
+  */
+  virtual ~AsyncEngine()
+  {
+    ;
+  }
+
+  /*!
+    \brief Returns the game state
+  */
+  const Game& getGame() const { return m_game; }
+
+  /*!
+    \brief Sets where the game's events are reported
+    \param sink The sink; it must outlive the engine. By default events
+    are discarded.
+    \param game Id of the game in the events
+  */
+  void setEventSink(GameEventSink& sink, uint32_t game = 0)
+  {
+    m_sink = &sink;
+    m_gameId = game;
+  }
+
+  /*!
+    \brief Returns a task that plays the game to the end
+    
+    The engine must outlive the task. The task throws InvalidMoveException
+    if a policy picks a move that does not exist.
+  */
+  Task<void> run();
+
+ private:
+  // Default constructor not defined
+  AsyncEngine();
+
+  //! Move decision policy to use for white
+  AsyncPolicy& m_white;
+
+  //! Move decision policy to use for black
+  AsyncPolicy& m_black;
+
+  //! The ongoing chess game
+  Game m_game;
+
+  //! Ends the game early
+  Adjudicator m_adjudicator;
+
+  //! Receives the game's events
+  GameEventSink* m_sink;
+
+  //! Id of the game in the events
+  uint32_t m_gameId;
+};
+
+} // namespace sage
+
+#endif
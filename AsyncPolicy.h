@@ -0,0 +1,105 @@
+#ifndef INCLUDED_sage_AsyncPolicy_h
+#define INCLUDED_sage_AsyncPolicy_h
+
+#ifndef INCLUDED_sage_Board_h
+#include "sage/Board.h"
+#endif
+
+#ifndef INCLUDED_sage_Move_h
+#include "sage/Move.h"
+#endif
+
+#ifndef INCLUDED_sage_Policy_h
+#include "sage/Policy.h"
+#endif
+
+#ifndef INCLUDED_sage_Task_h
+#include "sage/Task.h"
+#endif
+
+namespace sage {
+
+/*!
+  \brief Interface class for a chess decision policy that may suspend
+
+  This is the coroutine form of Policy. decide() is a coroutine, so a
+  policy can co_await work that is done in batches for many games at
+  once, such as an EvaluatorQueue, and the GameScheduler runs other games
+  in the meantime.
+*/
+class AsyncPolicy
+{
+ public:
+
+  /*!
+    \brief Default constructor
+  */
+  AsyncPolicy()
+  {
+    ;
+  }
+
+  /*!
+    \brief Destructor
+  */
+  virtual ~AsyncPolicy()
+  {
+    ;
+  }
+
+  /*!
+    \brief Decides which move to take for the given board
+    \param board The board on which we are making the move
+    \param moveList The list of moves to consider.
+    \return A task producing the index of move within moveList
+
+    The board and move list stay valid until the task finishes.
+  */
+  virtual Task<int> decide(const Board& board, const MoveList& moveList) = 0;
+
+ private:
+};
+
+/*!
+  \brief Lets an ordinary Policy play through the coroutine interface
+
+  The wrapped policy decides without ever suspending.
+*/
+class SyncPolicyAdapter : public AsyncPolicy
+{
+ public:
+
+  /*!
+    \brief Constructor
+    \param policy The policy to wrap; it must outlive the adapter
+  */
+  explicit SyncPolicyAdapter(Policy& policy)
+    : m_policy(policy)
+  {
+    ;
+  }
+
+  /*!
+    \brief Destructor
+  */
+  virtual ~SyncPolicyAdapter()
+  {
+    ;
+  }
+
+  virtual Task<int> decide(const Board& board, const MoveList& moveList)
+  {
+    co_return m_policy.decide(board, moveList);
+  }
+
+ private:
+  // Default constructor not defined
+  SyncPolicyAdapter();
+
+  //! The wrapped policy
+  Policy& m_policy;
+};
+
+} // namespace sage
+
+#endif
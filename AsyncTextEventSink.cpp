@@ -0,0 +1,150 @@
+#include "sage/AsyncTextEventSink.h"
+
+#ifndef INCLUDED_sage_TextEventSink_h
+#include "sage/TextEventSink.h"
+#endif
+
+#ifndef INCLUDED_std_chrono
+#include <chrono>
+#define INCLUDED_std_chrono
+#endif
+
+#ifndef INCLUDED_std_ostream
+#include <ostream>
+#define INCLUDED_std_ostream
+#endif
+
+#ifndef INCLUDED_std_string
+#include <string>
+#define INCLUDED_std_string
+#endif
+
+namespace sage {
+
+namespace {
+
+  //! How long the writer sleeps when there is nothing to write
+  const std::chrono::milliseconds IDLE_SLEEP(1);
+
+} // anonymous namespace
+
+AsyncTextEventSink::AsyncTextEventSink(std::ostream& out, size_t capacity)
+  : m_out(out), m_cells(), m_mask(0), m_tail(0), m_head(0), m_written(0),
+    m_stop(false), m_thread()
+{
+  size_t size = 1;
+  while (size < capacity)
+  {
+    size <<= 1;
+  }
+
+  m_cells.reset(new Cell[size]);
+  m_mask = size - 1;
+  for (size_t i = 0; i < size; ++i)
+  {
+    m_cells[i].m_sequence.store(i, std::memory_order_relaxed);
+  }
+
+  m_thread = std::thread(&AsyncTextEventSink::writerLoop, this);
+}
+
+AsyncTextEventSink::~AsyncTextEventSink()
+{
+  m_stop.store(true);
+  m_thread.join();
+}
+
+void AsyncTextEventSink::record(const GameEvent& event)
+{
+  size_t pos = m_tail.load(std::memory_order_relaxed);
+  Cell* cell;
+
+  for (;;)
+  {
+    cell = &m_cells[pos & m_mask];
+    size_t sequence = cell->m_sequence.load(std::memory_order_acquire);
+
+    if (sequence == pos)
+    {
+      // the slot is free; claim it unless another thread got there first
+      if (m_tail.compare_exchange_weak(pos, pos + 1,
+                                       std::memory_order_relaxed))
+      {
+        break;
+      }
+    }
+    else if (sequence < pos)
+    {
+      // the buffer is full; let the writer catch up
+      std::this_thread::yield();
+      pos = m_tail.load(std::memory_order_relaxed);
+    }
+    else
+    {
+      pos = m_tail.load(std::memory_order_relaxed);
+    }
+  }
+
+  cell->m_event = event;
+  cell->m_sequence.store(pos + 1, std::memory_order_release);
+}
+
+void AsyncTextEventSink::flush()
+{
+  size_t target = m_tail.load(std::memory_order_acquire);
+  while (m_written.load(std::memory_order_acquire) < target)
+  {
+    std::this_thread::sleep_for(IDLE_SLEEP);
+  }
+}
+
+bool AsyncTextEventSink::pop(GameEvent& event)
+{
+  Cell& cell = m_cells[m_head & m_mask];
+  if (cell.m_sequence.load(std::memory_order_acquire) != m_head + 1)
+  {
+    return false;
+  }
+
+  event = cell.m_event;
+
+  // free the slot for the pass of producers one buffer length ahead
+  cell.m_sequence.store(m_head + m_mask + 1, std::memory_order_release);
+  ++m_head;
+  return true;
+}
+
+void AsyncTextEventSink::writerLoop()
+{
+  std::string text;
+  GameEvent event;
+
+  for (;;)
+  {
+    // read the flag first, so nothing recorded before it was set is missed
+    bool stop = m_stop.load();
+
+    while (pop(event))
+    {
+      TextEventSink::format(event, text);
+    }
+
+    if (!text.empty())
+    {
+      m_out << text;
+      m_out.flush();
+      text.clear();
+      m_written.store(m_head, std::memory_order_release);
+    }
+    else if (stop)
+    {
+      break;
+    }
+    else
+    {
+      std::this_thread::sleep_for(IDLE_SLEEP);
+    }
+  }
+}
+
+} // namespace sage
@@ -0,0 +1,137 @@
+#ifndef INCLUDED_sage_AsyncTextEventSink_h
+#define INCLUDED_sage_AsyncTextEventSink_h
+
+#ifndef INCLUDED_sage_GameEvent_h
+#include "sage/GameEvent.h"
+#endif
+
+#ifndef INCLUDED_std_atomic
+#include <atomic>
+#define INCLUDED_std_atomic
+#endif
+
+#ifndef INCLUDED_std_cstddef
+#include <cstddef>
+#define INCLUDED_std_cstddef
+#endif
+
+#ifndef INCLUDED_std_iosfwd
+#include <iosfwd>
+#define INCLUDED_std_iosfwd
+#endif
+
+#ifndef INCLUDED_std_memory
+#include <memory>
+#define INCLUDED_std_memory
+#endif
+
+#ifndef INCLUDED_std_thread
+#include <thread>
+#define INCLUDED_std_thread
+#endif
+
+namespace sage {
+
+/*!
+  \brief Sink that writes events as text from a background thread
+
+  record() only copies the event into a ring buffer; a background thread
+  takes the events out, formats them one line each and writes them in
+  blocks. Games never wait on the stream, and the stream is flushed once
+  per block instead of once per line.
+
+  The ring buffer takes no locks: each slot carries a sequence number that
+  tells producers whether it is free and the writer whether it is filled.
+  Any number of threads may record at once. If the writer falls a whole
+  buffer behind, recording threads wait for it rather than drop events.
+
+  Lines are as from TextEventSink::format(). Since they reach the stream
+  some time after they are recorded, this sink does not suit interactive
+  play; use TextEventSink there.
+*/
+class AsyncTextEventSink : public GameEventSink
+{
+ public:
+
+  //! Constants used by the sink
+  enum Constant
+  {
+    DEFAULT_CAPACITY = 0x10000 //!< Events the ring buffer holds
+  };
+
+  /*!
+    \brief Constructor: starts the writer thread
+    \param out The stream to write to; it must outlive the sink and no one
+    else may write to it while the sink exists
+    \param capacity Events the ring buffer holds; rounded up to a power of
+    two
+  */
+  explicit AsyncTextEventSink(std::ostream& out,
+                              size_t capacity = DEFAULT_CAPACITY);
+
+  /*!
+    \brief Destructor: writes the remaining events and stops the thread
+  */
+  virtual ~AsyncTextEventSink();
+
+  virtual void record(const GameEvent& event);
+
+  /*!
+    \brief Waits until every event recorded so far has been written
+  */
+  virtual void flush();
+
+ private:
+  // Default constructor not defined
+  AsyncTextEventSink();
+
+  //! One slot of the ring buffer
+  struct Cell
+  {
+    //! Equals the position when free, position + 1 when filled
+    std::atomic<size_t> m_sequence;
+
+    //! The event
+    GameEvent m_event;
+  };
+
+  /*!
+    \brief Takes the next event out of the ring buffer; writer thread only
+    \retval true If an event was taken
+    \retval false If the buffer was empty
+  */
+  bool pop(GameEvent& event);
+
+  /*!
+    \brief Body of the writer thread
+  */
+  void writerLoop();
+
+  //! The stream to write to
+  std::ostream& m_out;
+
+  //! The ring buffer
+  std::unique_ptr<Cell[]> m_cells;
+
+  //! Number of slots minus one
+  size_t m_mask;
+
+  //! Next position to fill; shared by the recording threads
+  std::atomic<size_t> m_tail;
+
+  //! Next position to take; used by the writer thread only
+  size_t m_head;
+
+  //! Number of events written and flushed to the stream
+  std::atomic<size_t> m_written;
+
+  //! Set to stop the writer thread
+  std::atomic<bool> m_stop;
+
+  //! The writer thread
+  std::thread m_thread;
+};
+
+} // namespace sage
+
+#endif
@@ -0,0 +1,327 @@
+#include "sage/Attacks.h"
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define SAGE_ATTACKS_X86
+#ifndef INCLUDED_std_immintrin
+#include <immintrin.h>
+#define INCLUDED_std_immintrin
+#endif
+#endif
+
+namespace sage {
+
+bool Attacks::s_usePext = false;
+Attacks::Magic Attacks::s_rookMagics[BitboardUtil::NUM_SQUARES];
+Attacks::Magic Attacks::s_bishopMagics[BitboardUtil::NUM_SQUARES];
+Bitboard Attacks::s_knightAttacks[BitboardUtil::NUM_SQUARES];
+Bitboard Attacks::s_kingAttacks[BitboardUtil::NUM_SQUARES];
+Bitboard Attacks::s_pawnAttacks[2][BitboardUtil::NUM_SQUARES];
+Bitboard Attacks::s_between[BitboardUtil::NUM_SQUARES]
+                           [BitboardUtil::NUM_SQUARES];
+Bitboard Attacks::s_line[BitboardUtil::NUM_SQUARES]
+                        [BitboardUtil::NUM_SQUARES];
+
+namespace {
+
+  //! Total rook table size: sum over squares of 2^(relevant squares)
+  const int ROOK_TABLE_SIZE = 102400;
+
+  //! Total bishop table size: sum over squares of 2^(relevant squares)
+  const int BISHOP_TABLE_SIZE = 5248;
+
+  //! Maximum number of blocker subsets for a single square
+  const int MAX_SUBSETS = 4096;
+
+  Bitboard rookTable[ROOK_TABLE_SIZE];
+  Bitboard bishopTable[BISHOP_TABLE_SIZE];
+
+  const int ROOK_DELTAS[4][2] = { {1, 0}, {-1, 0}, {0, 1}, {0, -1} };
+  const int BISHOP_DELTAS[4][2] = { {1, 1}, {-1, 1}, {1, -1}, {-1, -1} };
+
+  const int KNIGHT_DELTAS[8][2] = { {1, 2}, {2, 1}, {2, -1}, {1, -2},
+                                    {-1, -2}, {-2, -1}, {-2, 1}, {-1, 2} };
+  const int KING_DELTAS[8][2] = { {1, 0}, {1, 1}, {0, 1}, {-1, 1},
+                                  {-1, 0}, {-1, -1}, {0, -1}, {1, -1} };
+
+  const Bitboard ROW_1 = 0x00000000000000ffULL;
+  const Bitboard ROW_8 = 0xff00000000000000ULL;
+  const Bitboard COLUMN_A = 0x0101010101010101ULL;
+  const Bitboard COLUMN_H = 0x8080808080808080ULL;
+
+  /*!
+    \brief Computes the squares reached by single steps from a square
+  */
+  Bitboard getStepAttacks(const int deltas[][2], int numDeltas, int square)
+  {
+    Bitboard attacks = 0;
+
+    for (int d = 0; d < numDeltas; ++d)
+    {
+      int col = BitboardUtil::getColumn(square) + deltas[d][0];
+      int row = BitboardUtil::getRow(square) + deltas[d][1];
+
+      if ((col >= 0) && (col < 8) && (row >= 0) && (row < 8))
+      {
+        attacks |= BitboardUtil::getMask(BitboardUtil::getSquare(col, row));
+      }
+    }
+
+    return attacks;
+  }
+
+  /*!
+    \brief Computes sliding attacks the slow way by walking each ray
+  */
+  Bitboard getSlidingAttacks(const int deltas[4][2], int square,
+                             Bitboard occupied)
+  {
+    Bitboard attacks = 0;
+
+    for (int d = 0; d < 4; ++d)
+    {
+      int col = BitboardUtil::getColumn(square) + deltas[d][0];
+      int row = BitboardUtil::getRow(square) + deltas[d][1];
+
+      while ((col >= 0) && (col < 8) && (row >= 0) && (row < 8))
+      {
+        Bitboard mask
+          = BitboardUtil::getMask(BitboardUtil::getSquare(col, row));
+        attacks |= mask;
+        if (occupied & mask)
+        {
+          break;
+        }
+
+        col += deltas[d][0];
+        row += deltas[d][1];
+      }
+    }
+
+    return attacks;
+  }
+
+  //! Per-row seeds for the magic search, chosen to converge quickly
+  const Bitboard MAGIC_SEEDS[8] 
+    = { 728, 10316, 55013, 32803, 12281, 15100, 16645, 255 };
+
+  /*!
+    \brief Small xorshift generator used to search for magic numbers
+
+    Fixed seeds keep the tables identical from run to run.
+  */
+  class MagicRandom
+  {
+   public:
+    MagicRandom(Bitboard seed)
+      : m_state(seed)
+    {
+      ;
+    }
+
+    Bitboard next()
+    {
+      m_state ^= m_state >> 12;
+      m_state ^= m_state << 25;
+      m_state ^= m_state >> 27;
+      return m_state * 2685821657736338717ULL;
+    }
+
+    //! Returns a random number with few bits set; these make good magics
+    Bitboard nextSparse() { return next() & next() & next(); }
+
+   private:
+    Bitboard m_state;
+  };
+
+  //! Builds the tables before main() runs
+  class AttacksInitializer
+  {
+   public:
+    AttacksInitializer()
+    {
+      Attacks::initialize(Attacks::isPextSupported());
+    }
+  };
+
+  AttacksInitializer attacksInitializer;
+
+} // anonymous namespace
+
+bool Attacks::isPextSupported()
+{
+#if defined(__BMI2__)
+  return true;
+#elif defined(SAGE_ATTACKS_X86)
+  return __builtin_cpu_supports("bmi2");
+#else
+  return false;
+#endif
+}
+
+#if defined(SAGE_ATTACKS_X86)
+__attribute__((target("bmi2")))
+unsigned int Attacks::getPextIndex(Bitboard occupied, Bitboard mask)
+{
+  return static_cast<unsigned int>(_pext_u64(occupied, mask));
+}
+#else
+unsigned int Attacks::getPextIndex(Bitboard occupied, Bitboard mask)
+{
+  // portable bit extraction; only reachable if initialize(true) was
+  // forced on a CPU without PEXT
+  unsigned int index = 0;
+  for (unsigned int bit = 1; mask; bit <<= 1, mask &= (mask - 1))
+  {
+    if (occupied & mask & (0 - mask))
+    {
+      index |= bit;
+    }
+  }
+  return index;
+}
+#endif
+
+void Attacks::initialize(bool usePext)
+{
+#if defined(__BMI2__)
+  // lookups are compiled to always use PEXT
+  usePext = true;
+#endif
+
+  s_usePext = usePext;
+  initializeLeapers();
+  initializeSlider(ROOK_DELTAS, s_rookMagics, rookTable);
+  initializeSlider(BISHOP_DELTAS, s_bishopMagics, bishopTable);
+  initializeLines();
+}
+
+void Attacks::initializeLines()
+{
+  for (int from = 0; from < BitboardUtil::NUM_SQUARES; ++from)
+  {
+    for (int to = 0; to < BitboardUtil::NUM_SQUARES; ++to)
+    {
+      Bitboard ends = (BitboardUtil::getMask(from) 
+                       | BitboardUtil::getMask(to));
+
+      s_between[from][to] = 0;
+      s_line[from][to] = 0;
+
+      if (getBishopAttacks(from, 0) & BitboardUtil::getMask(to))
+      {
+        s_line[from][to] = ((getBishopAttacks(from, 0)
+                             & getBishopAttacks(to, 0))
+                            | ends);
+        s_between[from][to] 
+          = (getBishopAttacks(from, BitboardUtil::getMask(to))
+             & getBishopAttacks(to, BitboardUtil::getMask(from)));
+      }
+      else if (getRookAttacks(from, 0) & BitboardUtil::getMask(to))
+      {
+        s_line[from][to] = ((getRookAttacks(from, 0)
+                             & getRookAttacks(to, 0))
+                            | ends);
+        s_between[from][to] 
+          = (getRookAttacks(from, BitboardUtil::getMask(to))
+             & getRookAttacks(to, BitboardUtil::getMask(from)));
+      }
+    }
+  }
+}
+
+void Attacks::initializeLeapers()
+{
+  const int WHITE_PAWN_DELTAS[2][2] = { {-1, 1}, {1, 1} };
+  const int BLACK_PAWN_DELTAS[2][2] = { {-1, -1}, {1, -1} };
+
+  for (int square = 0; square < BitboardUtil::NUM_SQUARES; ++square)
+  {
+    s_knightAttacks[square] = getStepAttacks(KNIGHT_DELTAS, 8, square);
+    s_kingAttacks[square] = getStepAttacks(KING_DELTAS, 8, square);
+    s_pawnAttacks[0][square] = getStepAttacks(WHITE_PAWN_DELTAS, 2, square);
+    s_pawnAttacks[1][square] = getStepAttacks(BLACK_PAWN_DELTAS, 2, square);
+  }
+}
+
+void Attacks::initializeSlider(const int deltas[4][2],
+                               Magic magics[BitboardUtil::NUM_SQUARES],
+                               Bitboard* table)
+{
+  Bitboard occupancy[MAX_SUBSETS];
+  Bitboard reference[MAX_SUBSETS];
+  int epoch[MAX_SUBSETS] = { 0 };
+  int attempt = 0;
+  Bitboard* attacks = table;
+
+  for (int square = 0; square < BitboardUtil::NUM_SQUARES; ++square)
+  {
+    // squares on the board edge never block anything further along the
+    // ray, so they are not relevant unless the piece is on that edge
+    Bitboard edges
+      = (((ROW_1 | ROW_8) & ~(ROW_1 << (8 * BitboardUtil::getRow(square))))
+         | ((COLUMN_A | COLUMN_H)
+            & ~(COLUMN_A << BitboardUtil::getColumn(square))));
+
+    Magic& magic = magics[square];
+    magic.m_mask = getSlidingAttacks(deltas, square, 0) & ~edges;
+    magic.m_shift = 64 - BitboardUtil::popCount(magic.m_mask);
+    magic.m_magic = 0;
+    magic.m_attacks = attacks;
+
+    // enumerate every subset of the mask (Carry-Rippler trick) along with
+    // the attacks it produces
+    int size = 0;
+    Bitboard subset = 0;
+    do
+    {
+      occupancy[size] = subset;
+      reference[size] = getSlidingAttacks(deltas, square, subset);
+      ++size;
+      subset = (subset - magic.m_mask) & magic.m_mask;
+    } while (subset);
+
+    attacks += size;
+
+    if (s_usePext)
+    {
+      for (int i = 0; i < size; ++i)
+      {
+        magic.m_attacks[getPextIndex(occupancy[i], magic.m_mask)]
+          = reference[i];
+      }
+      continue;
+    }
+
+    // search for a multiplier that maps every subset to a slot without
+    // destructive collisions
+    MagicRandom random(MAGIC_SEEDS[BitboardUtil::getRow(square)]);
+    for (int i = 0; i < size; )
+    {
+      do
+      {
+        magic.m_magic = random.nextSparse();
+      } while (BitboardUtil::popCount((magic.m_mask * magic.m_magic) >> 56)
+               < 6);
+
+      ++attempt;
+      for (i = 0; i < size; ++i)
+      {
+        unsigned int index
+          = static_cast<unsigned int>((occupancy[i] * magic.m_magic)
+                                      >> magic.m_shift);
+
+        if (epoch[index] < attempt)
+        {
+          epoch[index] = attempt;
+          magic.m_attacks[index] = reference[i];
+        }
+        else if (magic.m_attacks[index] != reference[i])
+        {
+          break;
+        }
+      }
+    }
+  }
+}
+
+} // namespace sage
@@ -0,0 +1,227 @@
+#ifndef INCLUDED_sage_Attacks_h
+#define INCLUDED_sage_Attacks_h
+
+#ifndef INCLUDED_sage_Bitboard_h
+#include "sage/Bitboard.h"
+#endif
+
+#if defined(__BMI2__)
+#ifndef INCLUDED_std_immintrin
+#include <immintrin.h>
+#define INCLUDED_std_immintrin
+#endif
+#endif
+
+namespace sage {
+
+/*!
+  \brief Precomputed attack tables for every piece type
+
+  Knight, king and pawn attacks depend only on the square and are stored
+  directly. Rook and bishop attack sets are looked up from tables indexed
+  by the relevant blockers on the piece's rays. The index is computed
+  either with a magic multiplication or, on CPUs that support BMI2, with
+  the PEXT instruction. The choice is made once when the tables are built at
+  program startup.
+
+  All methods are declared static so you don't have to instantiate this
+  class.
+*/
+class Attacks
+{
+ public:
+
+  /*!
+    \brief Returns the squares attacked by a rook
+    \param square The square the rook is on
+    \param occupied All pieces on the board
+    \return The attacked squares, including the first blocker on each ray
+  */
+  static Bitboard getRookAttacks(int square, Bitboard occupied)
+  {
+    return lookup(s_rookMagics[square], occupied);
+  }
+
+  /*!
+    \brief Returns the squares attacked by a bishop
+    \param square The square the bishop is on
+    \param occupied All pieces on the board
+    \return The attacked squares, including the first blocker on each ray
+  */
+  static Bitboard getBishopAttacks(int square, Bitboard occupied)
+  {
+    return lookup(s_bishopMagics[square], occupied);
+  }
+
+  /*!
+    \brief Returns the squares attacked by a queen
+    \param square The square the queen is on
+    \param occupied All pieces on the board
+    \return The attacked squares, including the first blocker on each ray
+  */
+  static Bitboard getQueenAttacks(int square, Bitboard occupied)
+  {
+    return (getRookAttacks(square, occupied)
+            | getBishopAttacks(square, occupied));
+  }
+
+  /*!
+    \brief Returns the squares attacked by a knight
+    \param square The square the knight is on
+  */
+  static Bitboard getKnightAttacks(int square)
+  {
+    return s_knightAttacks[square];
+  }
+
+  /*!
+    \brief Returns the squares attacked by a king
+    \param square The square the king is on
+  */
+  static Bitboard getKingAttacks(int square) { return s_kingAttacks[square]; }
+
+  /*!
+    \brief Returns the squares attacked by a pawn
+    \param colorIndex Board::getColorIndex() of the pawn's color
+    \param square The square the pawn is on
+  */
+  static Bitboard getPawnAttacks(int colorIndex, int square)
+  {
+    return s_pawnAttacks[colorIndex][square];
+  }
+
+  /*!
+    \brief Returns the squares strictly between two squares
+    \param from The first square
+    \param to The second square
+    \return The squares between them if they share a row, column or
+    diagonal; otherwise an empty bitboard
+  */
+  static Bitboard getBetween(int from, int to)
+  {
+    return s_between[from][to];
+  }
+
+  /*!
+    \brief Returns the full line through two squares
+    \param from The first square
+    \param to The second square
+    \return Every square on the row, column or diagonal shared by the
+    two squares, edge to edge; an empty bitboard if they are not aligned
+  */
+  static Bitboard getLine(int from, int to) { return s_line[from][to]; }
+
+  /*!
+    \brief Returns whether the tables are indexed with PEXT
+  */
+  static bool getUsePext() { return s_usePext; }
+
+  /*!
+    \brief Returns whether this CPU supports the PEXT instruction
+  */
+  static bool isPextSupported();
+
+  /*!
+    \brief Builds the attack tables
+    \param usePext Index with PEXT rather than magic multiplication. This
+    must only be true if isPextSupported() is true.
+
+    This is called automatically at program startup with PEXT enabled
+    whenever the CPU supports it. It can be called again to switch the
+    indexing method; it is not safe to do so while other threads are
+    looking up attacks.
+  */
+  static void initialize(bool usePext);
+
+ private:
+
+  //! Lookup parameters for one square of one sliding piece type
+  struct Magic
+  {
+    Bitboard m_mask;        //!< Relevant blocker squares
+    Bitboard m_magic;       //!< Magic multiplier
+    Bitboard* m_attacks;    //!< This square's slice of the attack table
+    unsigned int m_shift;   //!< 64 minus the number of relevant squares
+  };
+
+  /*!
+    \brief Computes the table index for the given blockers
+  */
+  static unsigned int getIndex(const Magic& magic, Bitboard occupied)
+  {
+#if defined(__BMI2__)
+    return static_cast<unsigned int>(_pext_u64(occupied, magic.m_mask));
+#else
+    if (s_usePext)
+    {
+      return getPextIndex(occupied, magic.m_mask);
+    }
+
+    return static_cast<unsigned int>(((occupied & magic.m_mask)
+                                      * magic.m_magic) >> magic.m_shift);
+#endif
+  }
+
+  /*!
+    \brief Computes a table index with PEXT on a CPU detected at runtime
+  */
+  static unsigned int getPextIndex(Bitboard occupied, Bitboard mask);
+
+  /*!
+    \brief Looks up the attacks for the given blockers
+  */
+  static Bitboard lookup(const Magic& magic, Bitboard occupied)
+  {
+    return magic.m_attacks[getIndex(magic, occupied)];
+  }
+
+  /*!
+    \brief Fills the knight, king and pawn attack tables
+  */
+  static void initializeLeapers();
+
+  /*!
+    \brief Fills the between and line tables from the slider tables
+  */
+  static void initializeLines();
+
+  /*!
+    \brief Fills the lookup parameters and table for one piece type
+    \param deltas The four ray directions as {column, row} steps
+    \param magics [out] Lookup parameters for each square
+    \param table [out] Attack table shared by all squares
+  */
+  static void initializeSlider(const int deltas[4][2],
+                               Magic magics[BitboardUtil::NUM_SQUARES],
+                               Bitboard* table);
+
+  //! Whether the tables are indexed with PEXT
+  static bool s_usePext;
+
+  //! Rook lookup parameters, indexed by square
+  static Magic s_rookMagics[BitboardUtil::NUM_SQUARES];
+
+  //! Bishop lookup parameters, indexed by square
+  static Magic s_bishopMagics[BitboardUtil::NUM_SQUARES];
+
+  //! Knight attacks, indexed by square
+  static Bitboard s_knightAttacks[BitboardUtil::NUM_SQUARES];
+
+  //! King attacks, indexed by square
+  static Bitboard s_kingAttacks[BitboardUtil::NUM_SQUARES];
+
+  //! Pawn attacks, indexed by color index and square
+  static Bitboard s_pawnAttacks[2][BitboardUtil::NUM_SQUARES];
+
+  //! Squares strictly between two aligned squares
+  static Bitboard s_between[BitboardUtil::NUM_SQUARES]
+                           [BitboardUtil::NUM_SQUARES];
+
+  //! Full line through two aligned squares
+  static Bitboard s_line[BitboardUtil::NUM_SQUARES]
+                        [BitboardUtil::NUM_SQUARES];
+};
+
+} // namespace sage
+
+#endif
@@ -0,0 +1,71 @@
+#include "sage/BinaryEventSink.h"
+
+#ifndef INCLUDED_std_ostream
+#include <ostream>
+#define INCLUDED_std_ostream
+#endif
+
+namespace sage {
+
+BinaryEventSink::BinaryEventSink(std::ostream& out, size_t capacity)
+  : m_out(out), m_buffer(), m_spare(),
+    m_capacity((capacity > 0) ? capacity : 1), m_mutex(), m_writeMutex()
+{
+  m_buffer.reserve(m_capacity);
+  m_spare.reserve(m_capacity);
+}
+
+BinaryEventSink::~BinaryEventSink()
+{
+  flush();
+}
+
+void BinaryEventSink::record(const GameEvent& event)
+{
+  std::unique_lock<std::mutex> lock(m_mutex);
+  m_buffer.push_back(event);
+  if (m_buffer.size() >= m_capacity)
+  {
+    write(lock);
+  }
+}
+
+void BinaryEventSink::flush()
+{
+  std::unique_lock<std::mutex> lock(m_mutex);
+  write(lock);
+  lock.unlock();
+
+  std::lock_guard<std::mutex> writeLock(m_writeMutex);
+  m_out.flush();
+}
+
+void BinaryEventSink::write(std::unique_lock<std::mutex>& lock)
+{
+  if (m_buffer.empty())
+  {
+    return;
+  }
+
+  std::vector<GameEvent> full;
+  full.swap(m_buffer);
+  m_buffer.swap(m_spare);
+
+  {
+    std::unique_lock<std::mutex> writeLock(m_writeMutex);
+    lock.unlock();
+    m_out.write(reinterpret_cast<const char*>(&full[0]),
+                full.size() * sizeof(GameEvent));
+  }
+
+  // the written buffer becomes the spare, unless another write already
+  // put one back
+  full.clear();
+  lock.lock();
+  if (m_spare.capacity() < full.capacity())
+  {
+    m_spare.swap(full);
+  }
+}
+
+} // namespace sage
@@ -0,0 +1,102 @@
+#ifndef INCLUDED_sage_BinaryEventSink_h
+#define INCLUDED_sage_BinaryEventSink_h
+
+#ifndef INCLUDED_sage_GameEvent_h
+#include "sage/GameEvent.h"
+#endif
+
+#ifndef INCLUDED_std_cstddef
+#include <cstddef>
+#define INCLUDED_std_cstddef
+#endif
+
+#ifndef INCLUDED_std_iosfwd
+#include <iosfwd>
+#define INCLUDED_std_iosfwd
+#endif
+
+#ifndef INCLUDED_std_mutex
+#include <mutex>
+#define INCLUDED_std_mutex
+#endif
+
+#ifndef INCLUDED_std_vector
+#include <vector>
+#endif
+
+namespace sage {
+
+/*!
+  \brief Sink that writes events to a stream as raw 16 byte records
+
+  Events are collected in a buffer and written in one block when it
+  fills up, so the stream sees one write per many thousand events. The
+  records are in the machine's byte order.
+
+  The sink is thread-safe. Recording takes a lock just long enough to copy
+  the event into the buffer. The thread that fills the buffer swaps in a
+  spare one and writes the full one after letting go of that lock, so the
+  other threads keep recording during the write. Blocks are written in
+  the order they filled up.
+*/
+class BinaryEventSink : public GameEventSink
+{
+ public:
+
+  //! Constants used by the sink
+  enum Constant
+  {
+    DEFAULT_CAPACITY = 0x4000 //!< Events buffered before a write
+  };
+
+  /*!
+    \brief Constructor
+    \param out The stream to write to; it must outlive the sink
+    \param capacity Events buffered before a write; at least 1
+  */
+  explicit BinaryEventSink(std::ostream& out,
+                           size_t capacity = DEFAULT_CAPACITY);
+
+  /*!
+    \brief Destructor: writes any buffered events
+  */
+  virtual ~BinaryEventSink();
+
+  virtual void record(const GameEvent& event);
+
+  virtual void flush();
+
+ private:
+  // Default constructor not defined
+  BinaryEventSink();
+
+  /*!
+    \brief Writes the buffer to the stream
+    \param lock Holds m_mutex; it is let go of during the write and held
+    again on return
+  */
+  void write(std::unique_lock<std::mutex>& lock);
+
+  //! The stream to write to
+  std::ostream& m_out;
+
+  //! Events not yet written
+  std::vector<GameEvent> m_buffer;
+
+  //! Empty buffer swapped in while the full one is written
+  std::vector<GameEvent> m_spare;
+
+  //! Events buffered before a write
+  size_t m_capacity;
+
+  //! Guards the buffers
+  std::mutex m_mutex;
+
+  //! Guards the stream; taken before m_mutex is let go of, so that blocks
+  //! are written in order
+  std::mutex m_writeMutex;
+};
+
+} // namespace sage
+
+#endif
@@ -0,0 +1,89 @@
+#ifndef INCLUDED_sage_Bitboard_h
+#define INCLUDED_sage_Bitboard_h
+
+#ifndef INCLUDED_std_stdint
+#include <stdint.h>
+#define INCLUDED_std_stdint
+#endif
+
+namespace sage {
+
+/*!
+  \brief A set of squares on the chess board, one bit per square.
+
+  Squares are numbered from 0 to 63 in row-major order starting at the
+  bottom left corner of the board: square 0 is [column 0, row 0] (a1),
+  square 7 is [column 7, row 0] (h1) and square 63 is [column 7, row 7]
+  (h8).
+*/
+typedef uint64_t Bitboard;
+
+/*!
+  \brief Helpers for converting between squares and bitboards
+
+  All methods are declared static so you don't have to instantiate this
+  class.
+*/
+class BitboardUtil
+{
+ public:
+
+  //! Constants defined by the bitboard layout
+  enum Constant
+  {
+    NUM_SQUARES = 64 //!< Number of squares (bits) in a bitboard
+  };
+
+  /*!
+    \brief Returns the square index for the given coordinates
+    \param col The column [0, 7]
+    \param row The row [0, 7]
+    \return The square index [0, NUM_SQUARES - 1]
+  */
+  static int getSquare(int col, int row) { return (row << 3) | col; }
+
+  /*!
+    \brief Returns the column of the given square index
+  */
+  static int getColumn(int square) { return square & 7; }
+
+  /*!
+    \brief Returns the row of the given square index
+  */
+  static int getRow(int square) { return square >> 3; }
+
+  /*!
+    \brief Returns a bitboard with only the given square set
+  */
+  static Bitboard getMask(int square)
+  {
+    return static_cast<Bitboard>(1) << square;
+  }
+
+  /*!
+    \brief Returns the number of squares set in the bitboard
+  */
+  static int popCount(Bitboard bb) { return __builtin_popcountll(bb); }
+
+  /*!
+    \brief Returns the lowest square set in the bitboard
+
+    The bitboard must not be empty.
+  */
+  static int getFirstSquare(Bitboard bb) { return __builtin_ctzll(bb); }
+
+  /*!
+    \brief Removes the lowest square from the bitboard and returns it
+    \param bb [inout] The bitboard, which must not be empty
+  */
+  static int popFirstSquare(Bitboard& bb)
+  {
+    int square = __builtin_ctzll(bb);
+    bb &= (bb - 1);
+    return square;
+  }
+};
+
+} // namespace sage
+
+#endif
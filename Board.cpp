@@ -4,20 +4,48 @@
 #include "sage/Exception.h"
 #endif
 
+#ifndef INCLUDED_sage_Attacks_h
+#include "sage/Attacks.h"
+#endif
+
 namespace sage {
 
+namespace {
+
+  //! Castling rights lost by any move that starts or ends on each square.
+  //! Moving the king or a rook off its square loses the right, and so does
+  //! capturing the rook where it stands.
+  const uint32_t CASTLE_LOSS[BitboardUtil::NUM_SQUARES] =
+  {
+    Board::FLAG_whiteQueenCastle, 0, 0, 0,
+    Board::FLAG_whiteKingCastle | Board::FLAG_whiteQueenCastle, 0, 0,
+    Board::FLAG_whiteKingCastle,
+    0, 0, 0, 0, 0, 0, 0, 0,
+    0, 0, 0, 0, 0, 0, 0, 0,
+    0, 0, 0, 0, 0, 0, 0, 0,
+    0, 0, 0, 0, 0, 0, 0, 0,
+    0, 0, 0, 0, 0, 0, 0, 0,
+    0, 0, 0, 0, 0, 0, 0, 0,
+    Board::FLAG_blackQueenCastle, 0, 0, 0,
+    Board::FLAG_blackKingCastle | Board::FLAG_blackQueenCastle, 0, 0,
+    Board::FLAG_blackKingCastle
+  };
+
+} // anonymous namespace
+
 Board::Board()
-  : m_whiteQueenCastle(true), m_whiteKingCastle(true),
-    m_blackQueenCastle(true), m_blackKingCastle(true),
-    m_enPassantCol(-1), m_turnColor(Board::COLOR_white)
+  : m_state(Board::FLAG_castleAll),
+    m_pieceHash(0),
+    m_pawnHash(0),
+    m_materialKey(0)
 {
-  for (int i = 0; i < Board::NUM_COLUMNS; ++i)
+  for (int i = 0; i < Piece::NUM_TYPES; ++i)
   {
-    for (int j = 0; j < Board::NUM_ROWS; ++j)
-    {
-      m_squares[i][j] = Piece(i, j, Piece::PIECE_none);
-    }
+    m_pieces[i] = 0;
   }
+
+  m_occupied[0] = 0;
+  m_occupied[1] = 0;
 }
 
 Board::~Board()
@@ -27,12 +55,17 @@ Board::~Board()
 
 void Board::applyMove(const Move& move)
 {
+  int startSquare = BitboardUtil::getSquare(move.getStartColumn(),
+                                            move.getStartRow());
+  int endSquare = BitboardUtil::getSquare(move.getEndColumn(),
+                                          move.getEndRow());
+
   // This is the piece that's moving
-  Piece movingPiece = m_squares[move.getStartColumn()][move.getStartRow()];
+  Piece::Type movingType = getPieceType(startSquare);
+  Piece movingPiece(move.getStartColumn(), move.getStartRow(), movingType);
 
   // This is the piece we're capturing (possibly none)
-  const Piece& capturePiece
-    = m_squares[move.getEndColumn()][move.getEndRow()];
+  Piece::Type captureType = getPieceType(endSquare);
 
   // Do some rudimentary checking to make sure the move "makes sense"
   if (move.getPiece() != movingPiece)
@@ -40,192 +73,261 @@ void Board::applyMove(const Move& move)
     throw InvalidMoveException("Moving piece does not match start space");
   }
   
-  if (move.getCapture() && (capturePiece.getType() == Piece::PIECE_none))
+  if (movingType == Piece::PIECE_none)
+  {
+    throw InvalidMoveException("No piece on start space");
+  }
+
+  if (move.getCapture() && !move.getEnPassant()
+      && (captureType == Piece::PIECE_none))
   {
     throw InvalidMoveException("Move is not capturing anything");
   }
 
-  if ((movingPiece.getType() & static_cast<int>(Piece::PIECE_whiteAll))
-      && (m_turnColor != Board::COLOR_white))
+  if ((movingType & static_cast<int>(Piece::PIECE_whiteAll))
+      && (getTurn() != Board::COLOR_white))
   {
     throw InvalidMoveException("Moving white piece on black's turn");
   }
 
-  if ((movingPiece.getType() & static_cast<int>(Piece::PIECE_blackAll))
-      && (m_turnColor != Board::COLOR_black))
+  if ((movingType & static_cast<int>(Piece::PIECE_blackAll))
+      && (getTurn() != Board::COLOR_black))
   {
     throw InvalidMoveException("Moving black piece on white's turn");
   }
 
-  // white castles kingside
-  if ((movingPiece.getType() == Piece::PIECE_whiteKing)
-      && (move.getStartRow() == 0)
-      && (move.getEndRow() == 0)
-      && (move.getStartColumn() == 4)
-      && (move.getEndColumn() == 6))
-  {
-    m_squares[4][0] = Piece(4, 0, Piece::PIECE_none);
-    m_squares[5][0] = Piece(5, 0, Piece::PIECE_whiteRook);
-    m_squares[6][0] = Piece(6, 0, Piece::PIECE_whiteKing);
-    m_squares[7][0] = Piece(7, 0, Piece::PIECE_none);
-  }
-  // white castles queenside
-  else if ((movingPiece.getType() == Piece::PIECE_whiteKing)
-           && (move.getStartRow() == 0)
-           && (move.getEndRow() == 0)
-           && (move.getStartColumn() == 4)
-           && (move.getEndColumn() == 2))
-  {
-    m_squares[4][0] = Piece(4, 0, Piece::PIECE_none);
-    m_squares[3][0] = Piece(3, 0, Piece::PIECE_whiteRook);
-    m_squares[2][0] = Piece(2, 0, Piece::PIECE_whiteKing);
-    m_squares[0][0] = Piece(0, 0, Piece::PIECE_none);
-  }
-  else if ((movingPiece.getType() == Piece::PIECE_blackKing)
-      && (move.getStartRow() == (Board::NUM_ROWS - 1))
-      && (move.getEndRow() == (Board::NUM_ROWS - 1))
-      && (move.getStartColumn() == 4)
-      && (move.getEndColumn() == 6))
-  {
-    m_squares[4][Board::NUM_ROWS - 1]
-      = Piece(4, (Board::NUM_ROWS - 1), Piece::PIECE_none);
-    m_squares[5][Board::NUM_ROWS - 1]
-      = Piece(5, (Board::NUM_ROWS - 1), Piece::PIECE_blackRook);
-    m_squares[6][Board::NUM_ROWS - 1]
-      = Piece(6, (Board::NUM_ROWS - 1), Piece::PIECE_blackKing);
-    m_squares[7][Board::NUM_ROWS - 1]
-      = Piece(7, (Board::NUM_ROWS - 1), Piece::PIECE_none);
-  }
-  // black castles queenside
-  else if ((movingPiece.getType() == Piece::PIECE_blackKing)
-           && (move.getStartRow() == (Board::NUM_ROWS - 1))
-           && (move.getEndRow() == (Board::NUM_ROWS - 1))
-           && (move.getStartColumn() == 4)
-           && (move.getEndColumn() == 2))
-  {
-    m_squares[4][Board::NUM_ROWS - 1]
-      = Piece(4, (Board::NUM_ROWS - 1), Piece::PIECE_none);
-    m_squares[3][Board::NUM_ROWS - 1]
-      = Piece(3, (Board::NUM_ROWS - 1), Piece::PIECE_blackRook);
-    m_squares[2][Board::NUM_ROWS - 1]
-      = Piece(2, (Board::NUM_ROWS - 1), Piece::PIECE_blackKing);
-    m_squares[0][Board::NUM_ROWS - 1]
-      = Piece(0, (Board::NUM_ROWS - 1), Piece::PIECE_none);
-  }
-  else
-  {
-    // Make the move
-    m_squares[move.getStartColumn()][move.getStartRow()] 
-      = Piece(move.getStartColumn(), move.getStartRow(), Piece::PIECE_none);
-    
-    m_squares[move.getEndColumn()][move.getEndRow()] 
-      = Piece(move.getEndColumn(), move.getEndRow(), movingPiece.getType());
-  }
+  Undo undo;
+  makeMove(move, undo);
+}
 
-  // adjust en passant square
-  adjustEnPassant(move);
+void Board::applyTrustedMove(PackedMove move)
+{
+  Undo undo;
+  makeMove(move, undo);
+}
 
-  // adjust castling flags
-  adjustCastling(move);
+void Board::makeMove(const Move& move, Undo& undo)
+{
+  makeMove(PackedMove::fromMove(move), undo);
+}
 
-  // switch whose turn it is
-  switchTurn();
+void Board::unmakeMove(const Move& move, const Undo& undo)
+{
+  unmakeMove(PackedMove::fromMove(move), undo);
 }
 
-PieceList Board::getPieceList() const
+void Board::makeMove(PackedMove move, Undo& undo)
 {
-  PieceList pieceList;
+  int from = move.getFrom();
+  int to = move.getTo();
+  Piece::Type movingType = getPieceType(from);
+  int colorIndex = ((movingType & static_cast<int>(Piece::PIECE_whiteAll))
+                    ? 0 : 1);
+
+  undo.m_captured = Piece::PIECE_none;
+  undo.m_state = m_state;
+
+  if (move.isCastle())
+  {
+    // king side: rook goes from column 7 to 5; queen side: 0 to 3
+    int row = BitboardUtil::getRow(from);
+    bool kingSide = (move.getFlags() == PackedMove::FLAG_kingCastle);
+    int rookStart = BitboardUtil::getSquare(kingSide ? 7 : 0, row);
+    int rookEnd = BitboardUtil::getSquare(kingSide ? 5 : 3, row);
 
-  for (int i = 0; i < Board::NUM_COLUMNS; ++i)
+    movePiece(movingType, from, to);
+    movePiece(((colorIndex == 0)
+               ? Piece::PIECE_whiteRook
+               : Piece::PIECE_blackRook),
+              rookStart, rookEnd);
+  }
+  else
   {
-    for (int j = 0; j < Board::NUM_ROWS; ++j)
+    if (move.isEnPassant())
     {
-      if (m_squares[i][j].getType() != Piece::PIECE_none)
-      {
-        pieceList.push_back(m_squares[i][j]);
-      }
+      // an en passant capture takes the pawn beside the start square
+      undo.m_captured = ((colorIndex == 0)
+                         ? Piece::PIECE_blackPawn
+                         : Piece::PIECE_whitePawn);
+      removePiece(undo.m_captured,
+                  BitboardUtil::getSquare(BitboardUtil::getColumn(to),
+                                          BitboardUtil::getRow(from)));
+    }
+    else if (getOccupied() & BitboardUtil::getMask(to))
+    {
+      undo.m_captured = getPieceType(to);
+      removePiece(undo.m_captured, to);
     }
-  }
-
-  return pieceList;
-}
 
-void Board::adjustEnPassant(const Move& move)
-{
-  // This is the piece that's moving
-  Piece movingPiece = m_squares[move.getStartColumn()][move.getStartRow()];
+    // Make the move
+    if (move.isPromotion())
+    {
+      removePiece(movingType, from);
+      putPiece(move.getPromotionType(colorIndex), to);
+    }
+    else
+    {
+      movePiece(movingType, from, to);
+    }
+  }
 
-  if ((movingPiece.getType() == Piece::PIECE_whitePawn)
-      && (move.getStartRow() == 1)
-      && (move.getEndRow() == 3))
+  // adjust en passant square. it is only recorded if an enemy pawn is in
+  // place to capture, so that positions that only differ by an unusable en
+  // passant square hash the same
+  int enPassantColumn = -1;
+  if (move.getFlags() == PackedMove::FLAG_doublePush)
   {
-    m_enPassantCol = move.getStartColumn();
+    int passed = (from + to) / 2;
+    Bitboard enemyPawns = m_pieces[Piece::getIndex((colorIndex == 0)
+                                                   ? Piece::PIECE_blackPawn
+                                                   : Piece::PIECE_whitePawn)];
+    if (Attacks::getPawnAttacks(colorIndex, passed) & enemyPawns)
+    {
+      enPassantColumn = BitboardUtil::getColumn(from);
+    }
   }
-  else if ((movingPiece.getType() == Piece::PIECE_blackPawn)
-      && (move.getStartRow() == 6)
-      && (move.getEndRow() == 4))
+  setEnPassantColumn(enPassantColumn);
+
+  // captures and pawn moves reset the halfmove clock
+  if ((movingType & static_cast<int>(Piece::PIECE_anyPawn))
+      || (undo.m_captured != Piece::PIECE_none))
   {
-    m_enPassantCol = move.getStartColumn();
+    setHalfmoveClock(0);
   }
   else
   {
-    m_enPassantCol = -1;
+    setHalfmoveClock(getHalfmoveClock() + 1);
   }
-}
 
+  // adjust castling flags
+  m_state &= ~(CASTLE_LOSS[from] | CASTLE_LOSS[to]);
 
-void Board::adjustCastling(const Move& move)
+  // switch whose turn it is
+  switchTurn();
+}
+
+void Board::unmakeMove(PackedMove move, const Undo& undo)
 {
-  if (m_turnColor == Board::COLOR_white)
+  int from = move.getFrom();
+  int to = move.getTo();
+
+  m_state = undo.m_state;
+  int colorIndex = getColorIndex(getTurn());
+
+  if (move.isCastle())
   {
-    if (m_squares[0][0].getType() != Piece::PIECE_whiteRook)
-    {
-      m_whiteQueenCastle = false;
-    }
+    int row = BitboardUtil::getRow(from);
+    bool kingSide = (move.getFlags() == PackedMove::FLAG_kingCastle);
+    int rookStart = BitboardUtil::getSquare(kingSide ? 7 : 0, row);
+    int rookEnd = BitboardUtil::getSquare(kingSide ? 5 : 3, row);
 
-    if (m_squares[NUM_COLUMNS - 1][0].getType() != Piece::PIECE_whiteRook)
+    if (colorIndex == 0)
     {
-      m_whiteKingCastle = false;
+      movePiece(Piece::PIECE_whiteKing, to, from);
+      movePiece(Piece::PIECE_whiteRook, rookEnd, rookStart);
     }
-
-    if (m_squares[4][0].getType() != Piece::PIECE_whiteKing)
+    else
     {
-      m_whiteKingCastle = false;
-      m_whiteQueenCastle = false;
+      movePiece(Piece::PIECE_blackKing, to, from);
+      movePiece(Piece::PIECE_blackRook, rookEnd, rookStart);
     }
+    return;
+  }
+
+  if (move.isPromotion())
+  {
+    removePiece(move.getPromotionType(colorIndex), to);
+    putPiece(((colorIndex == 0)
+              ? Piece::PIECE_whitePawn
+              : Piece::PIECE_blackPawn),
+             from);
   }
   else
   {
-    if (m_squares[0][NUM_ROWS - 1].getType() != Piece::PIECE_blackRook)
+    movePiece(getPieceType(to), to, from);
+  }
+
+  if (undo.m_captured != Piece::PIECE_none)
+  {
+    if (move.isEnPassant())
     {
-      m_blackQueenCastle = false;
+      putPiece(undo.m_captured,
+               BitboardUtil::getSquare(BitboardUtil::getColumn(to),
+                                       BitboardUtil::getRow(from)));
     }
-
-    if (m_squares[NUM_COLUMNS - 1][NUM_ROWS - 1].getType() 
-        != Piece::PIECE_blackRook)
+    else
     {
-      m_blackKingCastle = false;
+      putPiece(undo.m_captured, to);
     }
+  }
+}
 
-    if (m_squares[4][NUM_ROWS - 1].getType() != Piece::PIECE_blackKing)
+PieceList Board::getPieceList() const
+{
+  PieceList pieceList;
+
+  Bitboard occupied = getOccupied();
+  while (occupied)
+  {
+    int square = BitboardUtil::popFirstSquare(occupied);
+    pieceList.push_back(Piece(BitboardUtil::getColumn(square),
+                              BitboardUtil::getRow(square),
+                              getPieceType(square)));
+  }
+
+  return pieceList;
+}
+
+HashKey Board::computeHash() const
+{
+  HashKey hash = Zobrist::getStateKey(m_state);
+
+  for (int i = 0; i < Piece::NUM_TYPES; ++i)
+  {
+    Bitboard pieces = m_pieces[i];
+    while (pieces)
     {
-      m_blackKingCastle = false;
-      m_blackQueenCastle = false;
+      hash ^= Zobrist::getPieceKey(i, BitboardUtil::popFirstSquare(pieces));
     }
   }
-}
 
+  return hash;
+}
 
-void Board::switchTurn()
+HashKey Board::computePawnHash() const
 {
-  if (m_turnColor == Board::COLOR_white)
+  HashKey hash = 0;
+  const Piece::Type pawns[2] = { Piece::PIECE_whitePawn,
+                                 Piece::PIECE_blackPawn };
+
+  for (int c = 0; c < 2; ++c)
   {
-    m_turnColor = Board::COLOR_black;
+    int index = Piece::getIndex(pawns[c]);
+    Bitboard pieces = m_pieces[index];
+    while (pieces)
+    {
+      hash ^= Zobrist::getPieceKey(index,
+                                   BitboardUtil::popFirstSquare(pieces));
+    }
   }
-  else
+
+  return hash;
+}
+
+MaterialKey Board::computeMaterialKey() const
+{
+  MaterialKey key = 0;
+
+  for (int i = 0; i < Piece::NUM_TYPES; ++i)
   {
-    m_turnColor = Board::COLOR_white;
+    Bitboard pieces = m_pieces[i];
+    while (pieces)
+    {
+      key += Material::getPieceKey(i, BitboardUtil::popFirstSquare(pieces));
+    }
   }
+
+  return key;
 }
 
 } // namespace sage
@@ -9,10 +9,41 @@
 #include "sage/Move.h"
 #endif
 
+#ifndef INCLUDED_sage_PackedMove_h
+#include "sage/PackedMove.h"
+#endif
+
+#ifndef INCLUDED_sage_Bitboard_h
+#include "sage/Bitboard.h"
+#endif
+
+#ifndef INCLUDED_sage_Zobrist_h
+#include "sage/Zobrist.h"
+#endif
+
+#ifndef INCLUDED_sage_Material_h
+#include "sage/Material.h"
+#endif
+
 namespace sage {
 
 /*!
   \brief Class that captures the entire state of a chess game.
+
+  The position is stored as one bitboard per piece type plus one occupancy
+  bitboard per color. Castling rights, the en passant column and the side
+  to move are packed into a single state word. This keeps the board small
+  and cheap to copy; the square-based accessors below (getPiece, isEmpty,
+  addPiece) are implemented on top of the bitboards.
+
+  The board also keeps a Zobrist hash of the pieces, and a second one of
+  just the pawns, updated incrementally as pieces are added, moved and
+  removed. getHash() combines the piece hash with the key for the state
+  word to identify the whole position.
+
+  A material key (see Material) counting the pieces of each class is kept
+  the same way, so that dead-drawn material is recognised with one table
+  lookup per move.
 */
 class Board
 {
@@ -28,8 +59,38 @@ class Board
   //! Constants defined by the chess board
   enum Constant
   {
-    NUM_COLUMNS = 8, //!< Number of columns on the board
-    NUM_ROWS = 8     //!< Number of rows on the board
+    NUM_COLUMNS = 8,          //!< Number of columns on the board
+    NUM_ROWS = 8,             //!< Number of rows on the board
+    MAX_HALFMOVE_CLOCK = 0xff //!< Largest value of the halfmove clock
+  };
+
+  /*!
+    \brief Board state destroyed by a move
+
+    makeMove() fills one of these in and unmakeMove() uses it to restore
+    the board. Callers keep one record per ply, usually on their own stack,
+    so that a search can walk the game tree on a single board without
+    copying it.
+  */
+  struct Undo
+  {
+    Piece::Type m_captured; //!< The piece captured; PIECE_none if none
+    uint32_t m_state;       //!< The state word before the move
+  };
+
+  //! Bits of the packed state word
+  enum StateFlag
+  {
+    FLAG_whiteKingCastle  = 0x000001, //!< White can castle on king side
+    FLAG_whiteQueenCastle = 0x000002, //!< White can castle on queen side
+    FLAG_blackKingCastle  = 0x000004, //!< Black can castle on king side
+    FLAG_blackQueenCastle = 0x000008, //!< Black can castle on queen side
+    FLAG_castleAll        = 0x00000f, //!< All castling rights
+    FLAG_enPassantMask    = 0x0000f0, //!< En passant column + 1; 0 if none
+    FLAG_enPassantShift   = 4,        //!< Shift of the en passant field
+    FLAG_blackTurn        = 0x000100, //!< Set if it is black's turn to move
+    FLAG_halfmoveMask     = 0xff0000, //!< Halfmove clock
+    FLAG_halfmoveShift    = 16        //!< Shift of the halfmove clock
   };
 
   /*!
@@ -47,42 +108,61 @@ class Board
     \retval true If white can castle on Queen side
     \retval false If white cannot castle on Queen side
    */
-  bool getWhiteQueenCastle() const { return m_whiteQueenCastle; }
+  bool getWhiteQueenCastle() const
+  {
+    return (m_state & FLAG_whiteQueenCastle) != 0;
+  }
 
   /*!
     \brief Returns whether white can castle on the king side
     \retval true If white can castle on King side
     \retval false If white cannot castle on King side
    */
-  bool getWhiteKingCastle() const { return m_whiteKingCastle; }
+  bool getWhiteKingCastle() const
+  {
+    return (m_state & FLAG_whiteKingCastle) != 0;
+  }
 
   /*!
     \brief Returns whether black can castle on the queen side
     \retval true If black can castle on Queen side
     \retval false If black cannot castle on Queen side
    */
-  bool getBlackQueenCastle() const { return m_blackQueenCastle; }
+  bool getBlackQueenCastle() const
+  {
+    return (m_state & FLAG_blackQueenCastle) != 0;
+  }
 
   /*!
     \brief Returns whether black can castle on the king side
     \retval true If black can castle on King side
     \retval false If black cannot castle on King side
    */
-  bool getBlackKingCastle() const { return m_blackKingCastle; }
+  bool getBlackKingCastle() const
+  {
+    return (m_state & FLAG_blackKingCastle) != 0;
+  }
 
   /*!
     \brief Returns the en passant column available for the next move.
     \retval -1 If no en passant column
     \retval [0 - Board::NUM_COLUMNS] If en passant column available
   */
-  int getEnPassantColumn() const { return m_enPassantCol; }
+  int getEnPassantColumn() const
+  {
+    return static_cast<int>((m_state & FLAG_enPassantMask)
+                            >> FLAG_enPassantShift) - 1;
+  }
 
   /*!
     \brief Returns the color whose turn it is to move
     \retval COLOR_white If it is white's turn to move
     \retval COLOR_black If it is black's turn to move
   */
-  Color getTurn() const { return m_turnColor; }
+  Color getTurn() const
+  {
+    return ((m_state & FLAG_blackTurn) ? COLOR_black : COLOR_white);
+  }
 
   /*!
     \brief Returns the color who is not moving
@@ -91,27 +171,158 @@ class Board
   */
   Color getOppositeTurn() const 
   {
-    if (m_turnColor == COLOR_white)
+    return ((m_state & FLAG_blackTurn) ? COLOR_white : COLOR_black);
+  }
+
+  /*!
+    \brief Returns the packed state word
+
+    See StateFlag for the layout. This captures castling rights, the en
+    passant column, the side to move and the halfmove clock in a single
+    value.
+  */
+  uint32_t getStateWord() const { return m_state; }
+
+  /*!
+    \brief Returns the number of halfmoves since the last capture or pawn
+    move
+    \return The halfmove clock [0, MAX_HALFMOVE_CLOCK]
+
+    This is what the fifty-move rule counts. The clock stops at
+    MAX_HALFMOVE_CLOCK, well beyond the 100 halfmoves the rule needs.
+  */
+  int getHalfmoveClock() const
+  {
+    return static_cast<int>((m_state & FLAG_halfmoveMask)
+                            >> FLAG_halfmoveShift);
+  }
+
+  /*!
+    \brief Returns the Zobrist hash of the position
+
+    This covers the pieces, castling rights, en passant column and side to
+    move, but not the halfmove clock. Two boards with the same position
+    have the same hash.
+  */
+  HashKey getHash() const
+  {
+    return m_pieceHash ^ Zobrist::getStateKey(m_state);
+  }
+
+  /*!
+    \brief Returns the Zobrist hash of the pawns of both colors
+
+    This only changes when a pawn moves, is captured or promotes, so it
+    is useful for caching pawn structure evaluation.
+  */
+  HashKey getPawnHash() const { return m_pawnHash; }
+
+  /*!
+    \brief Computes the Zobrist hash of the position from scratch
+    \return The hash, which must equal getHash()
+
+    This is much slower than getHash() and is meant for verifying the
+    incremental updates.
+  */
+  HashKey computeHash() const;
+
+  /*!
+    \brief Computes the Zobrist hash of the pawns from scratch
+    \return The hash, which must equal getPawnHash()
+  */
+  HashKey computePawnHash() const;
+
+  /*!
+    \brief Returns the material key of the position
+
+    See Material for the layout. It changes only when a piece is captured
+    or a pawn promotes.
+  */
+  MaterialKey getMaterialKey() const { return m_materialKey; }
+
+  /*!
+    \brief Computes the material key from scratch
+    \return The key, which must equal getMaterialKey()
+  */
+  MaterialKey computeMaterialKey() const;
+
+  /*!
+    \brief Returns the chess piece at the specified coordinates
+    \param col The column at which to look. [0, NUM_COLUMNS - 1]
+    \param row The row at which to look. [0, NUM_ROW - 1]
+    \return The chess piece at that position
+
+    The piece is built on demand from the bitboards, so it is returned
+    by value.
+  */
+  Piece getPiece(int col, int row) const
+  {
+    return Piece(col, row, 
+                 getPieceType(BitboardUtil::getSquare(col, row)));
+  }
+
+  /*!
+    \brief Returns the type of the piece on the given square
+    \param square The square index [0, BitboardUtil::NUM_SQUARES - 1]
+    \return The piece type; PIECE_none if the square is empty
+  */
+  Piece::Type getPieceType(int square) const
+  {
+    Bitboard mask = BitboardUtil::getMask(square);
+    int first;
+    if (m_occupied[0] & mask)
     {
-      return COLOR_black;
+      first = 0;
+    }
+    else if (m_occupied[1] & mask)
+    {
+      first = 6;
     }
     else
     {
-      return COLOR_white;
+      return Piece::PIECE_none;
+    }
+
+    for (int i = first; i < (first + 5); ++i)
+    {
+      if (m_pieces[i] & mask)
+      {
+        return Piece::getTypeFromIndex(i);
+      }
     }
+
+    return Piece::getTypeFromIndex(first + 5);
   }
 
   /*!
-    \brief Returns the chess piece at the specified coordinates
-    \param col The column at which to look. [0, NUM_COLUMNS - 1]
-    \param row The row at which to look. [0, NUM_ROW - 1]
-    \return The chess piece at that position
+    \brief Returns the bitboard of all pieces of the given type
+    \param type The piece type; must not be PIECE_none
   */
-  const Piece& getPiece(int col, int row) const
+  Bitboard getPieces(Piece::Type type) const
   {
-    return m_squares[col][row];
+    return m_pieces[Piece::getIndex(type)];
   }
 
+  /*!
+    \brief Returns the bitboard of all pieces of the given color
+  */
+  Bitboard getOccupied(Color color) const
+  {
+    return m_occupied[getColorIndex(color)];
+  }
+
+  /*!
+    \brief Returns the bitboard of all pieces on the board
+  */
+  Bitboard getOccupied() const { return m_occupied[0] | m_occupied[1]; }
+
+  /*!
+    \brief Returns the index of a color for use in arrays
+    \retval 0 For COLOR_white
+    \retval 1 For COLOR_black
+  */
+  static int getColorIndex(Color color) { return (color - COLOR_white); }
+
   /*!
     \brief Checks if the specified square is empty
     \param col The column to check
@@ -121,32 +332,33 @@ class Board
   */
   bool isEmpty(int col, int row) const
   {
-    return (m_squares[col][row].getType() == Piece::PIECE_none);
+    return !(getOccupied() 
+             & BitboardUtil::getMask(BitboardUtil::getSquare(col, row)));
   }
 
   /*!
     \brief Sets whether white can castle on the queen's side
     \param val true if white can castle on queen's side; false otherwise
   */
-  void setWhiteQueenCastle(bool val) { m_whiteQueenCastle = val; }
+  void setWhiteQueenCastle(bool val) { setFlag(FLAG_whiteQueenCastle, val); }
 
   /*!
     \brief Sets whether white can castle on the king's side
     \param val true if white can castle on king's side; false otherwise
   */
-  void setWhiteKingCastle(bool val) { m_whiteKingCastle = val; }
+  void setWhiteKingCastle(bool val) { setFlag(FLAG_whiteKingCastle, val); }
 
   /*!
     \brief Sets whether black can castle on the queen's side
     \param val true if black can castle on queen's side; false otherwise
   */
-  void setBlackQueenCastle(bool val) { m_blackQueenCastle = val; }
+  void setBlackQueenCastle(bool val) { setFlag(FLAG_blackQueenCastle, val); }
 
   /*!
     \brief Sets whether black can castle on the king's side
     \param val true if black can castle on king's side; false otherwise
   */
-  void setBlackKingCastle(bool val) { m_blackKingCastle = val; }
+  void setBlackKingCastle(bool val) { setFlag(FLAG_blackKingCastle, val); }
 
   /*!
     \brief Sets the en passant column
@@ -155,23 +367,55 @@ class Board
     The valid values for val are -1 if no en passant column, and any 
     number in the range [0, NUM_COLUMNS-1]
   */
-  void setEnPassantColumn(int val) { m_enPassantCol = val; }
+  void setEnPassantColumn(int val)
+  {
+    m_state = ((m_state & ~static_cast<uint32_t>(FLAG_enPassantMask))
+               | (static_cast<uint32_t>(val + 1) << FLAG_enPassantShift));
+  }
 
   /*!
     \brief Sets the color whose turn it is to play
     \param val Color to play next
   */
-  void setTurn(Color val) { m_turnColor = val; }
+  void setTurn(Color val) { setFlag(FLAG_blackTurn, (val == COLOR_black)); }
+
+  /*!
+    \brief Sets the halfmove clock
+    \param val Halfmoves since the last capture or pawn move; values above
+    MAX_HALFMOVE_CLOCK are stored as MAX_HALFMOVE_CLOCK
+  */
+  void setHalfmoveClock(int val)
+  {
+    if (val > MAX_HALFMOVE_CLOCK)
+    {
+      val = MAX_HALFMOVE_CLOCK;
+    }
+
+    m_state = ((m_state & ~static_cast<uint32_t>(FLAG_halfmoveMask))
+               | (static_cast<uint32_t>(val) << FLAG_halfmoveShift));
+  }
 
   /*!
     \brief Sets the specified column and row to a specific piece
     \param piece The piece to add
 
     The piece is added at the coordinates specified in the piece argument.
+    Any piece already on that square is removed first; adding a piece of
+    type PIECE_none simply clears the square.
   */ 
   void addPiece(const Piece& piece)
   {
-    m_squares[piece.getColumn()][piece.getRow()] = piece;
+    int square = BitboardUtil::getSquare(piece.getColumn(), piece.getRow());
+    Piece::Type oldType = getPieceType(square);
+    if (oldType != Piece::PIECE_none)
+    {
+      removePiece(oldType, square);
+    }
+
+    if (piece.getType() != Piece::PIECE_none)
+    {
+      putPiece(piece.getType(), square);
+    }
   }
 
   /*!
@@ -183,6 +427,55 @@ class Board
   */
   void applyMove(const Move& move);
 
+  /*!
+    \brief Applies a move from the move generator
+    \param move The move to apply. It must be legal for this board.
+
+    Unlike applyMove(), the move is not checked against the board and no
+    exception is thrown, so this is meant for moves that come from the
+    generator rather than from outside input.
+  */
+  void applyTrustedMove(PackedMove move);
+
+  /*!
+    \brief Makes the given move without validating it
+    \param move The move to make. It must be a legal (or at least
+    pseudo-legal) move for this board, such as one produced by the move
+    generator.
+    \param undo [out] Receives what is needed to take the move back
+
+    This does the same updates as applyMove(), but skips the sanity checks
+    so it can be used inside search. Pass the same move and undo record to
+    unmakeMove() to restore the board.
+  */
+  void makeMove(const Move& move, Undo& undo);
+
+  /*!
+    \brief Takes back a move made with makeMove()
+    \param move The move that was made
+    \param undo The record filled in by makeMove()
+
+    Moves must be taken back in the reverse order they were made.
+  */
+  void unmakeMove(const Move& move, const Undo& undo);
+
+  /*!
+    \brief Makes the given packed move without validating it
+    \param move The move to make, as produced by the move generator
+    \param undo [out] Receives what is needed to take the move back
+
+    This is the version used by search and perft; the Move version packs
+    its argument and calls this one.
+  */
+  void makeMove(PackedMove move, Undo& undo);
+
+  /*!
+    \brief Takes back a packed move made with makeMove()
+    \param move The move that was made
+    \param undo The record filled in by makeMove()
+  */
+  void unmakeMove(PackedMove move, const Undo& undo);
+
   /*!
     \brief Gets the list of pieces on this board
     \return The piece list
@@ -192,42 +485,108 @@ class Board
  private:
 
   /*!
-    \brief Adjusts m_enPassantCol for the given move
-    \param move The move made on this board
+    \brief Places a piece on an empty square
+    \param type The piece type; must not be PIECE_none
+    \param square The square index
+  */
+  void putPiece(Piece::Type type, int square)
+  {
+    Bitboard mask = BitboardUtil::getMask(square);
+    int index = Piece::getIndex(type);
+    m_pieces[index] |= mask;
+    m_occupied[(index < 6) ? 0 : 1] |= mask;
+    updateHash(type, index, Zobrist::getPieceKey(index, square));
+    m_materialKey += Material::getPieceKey(index, square);
+  }
+
+  /*!
+    \brief Removes a piece of known type from the given square
+    \param type The piece type; must not be PIECE_none
+    \param square The square index
+  */
+  void removePiece(Piece::Type type, int square)
+  {
+    Bitboard mask = ~BitboardUtil::getMask(square);
+    int index = Piece::getIndex(type);
+    m_pieces[index] &= mask;
+    m_occupied[(index < 6) ? 0 : 1] &= mask;
+    updateHash(type, index, Zobrist::getPieceKey(index, square));
+    m_materialKey -= Material::getPieceKey(index, square);
+  }
+
+  /*!
+    \brief Moves a piece of known type between two squares
+    \param type The piece type; must not be PIECE_none
+    \param from The square the piece is on
+    \param to The empty square the piece moves to
+
+    Moving never changes the material key, since bishops stay on squares
+    of one color.
   */
-  void adjustEnPassant(const Move& move);
+  void movePiece(Piece::Type type, int from, int to)
+  {
+    Bitboard mask = (BitboardUtil::getMask(from) | BitboardUtil::getMask(to));
+    int index = Piece::getIndex(type);
+    m_pieces[index] ^= mask;
+    m_occupied[(index < 6) ? 0 : 1] ^= mask;
+    updateHash(type, index, (Zobrist::getPieceKey(index, from)
+                             ^ Zobrist::getPieceKey(index, to)));
+  }
 
   /*!
-    \brief Adjusts m_(white|black)(Queen|King)Castle  for the given move
-    \param move The move made on this board
+    \brief Toggles a piece key in the hashes
+    \param type The piece type
+    \param index Piece::getIndex() of the type
+    \param key The key (or XOR of keys) to toggle
   */
-  void adjustCastling(const Move& move);
+  void updateHash(Piece::Type type, int index, HashKey key)
+  {
+    m_pieceHash ^= key;
+    if (type & static_cast<int>(Piece::PIECE_anyPawn))
+    {
+      m_pawnHash ^= key;
+    }
+  }
 
   /*!
-    \brief Switches the value of m_turnColor
+    \brief Sets or clears bits of the packed state word
+    \param flag The bits to change
+    \param val true to set the bits; false to clear them
   */
-  void switchTurn();
+  void setFlag(StateFlag flag, bool val)
+  {
+    if (val)
+    {
+      m_state |= flag;
+    }
+    else
+    {
+      m_state &= ~static_cast<uint32_t>(flag);
+    }
+  }
 
-  //! White can castle on queen side
-  bool m_whiteQueenCastle;
+  /*!
+    \brief Switches the side to move
+  */
+  void switchTurn() { m_state ^= FLAG_blackTurn; }
 
-  //! White can castle on king side
-  bool m_whiteKingCastle;
+  //! Pieces on the board, one bitboard per Piece::getIndex()
+  Bitboard m_pieces[Piece::NUM_TYPES];
 
-  //! Black can castle on queen side
-  bool m_blackQueenCastle;
+  //! All pieces of each color, indexed by getColorIndex()
+  Bitboard m_occupied[2];
 
-  //! Black can castle on king side
-  bool m_blackKingCastle;
+  //! Castling rights, en passant column and side to move; see StateFlag
+  uint32_t m_state;
 
-  //! En passant column; set to -1 if none
-  int m_enPassantCol;
+  //! Zobrist hash of the pieces only; getHash() adds the state key
+  HashKey m_pieceHash;
 
-  //! The color whose turn it is to move
-  Color m_turnColor;
+  //! Zobrist hash of the pawns
+  HashKey m_pawnHash;
 
-  //! Pieces on the board. Indexed by [column][row] starting at 0.
-  Piece m_squares[NUM_COLUMNS][NUM_ROWS];
+  //! Count of the pieces of each class
+  MaterialKey m_materialKey;
 };
 
 } // namespace sage
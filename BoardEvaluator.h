@@ -40,6 +40,26 @@ class BoardEvaluator
   */
   virtual double evaluate(const Board& board) = 0;
 
+  /*!
+    \brief Evaluates several boards at once
+    \param boards The boards to evaluate
+    \param scores [out] The score of each board, as from evaluate()
+    \param count The number of boards
+
+    The default evaluates the boards one at a time. Evaluators that work
+    faster in bulk (e.g. on vector units) can override this; EvaluatorQueue
+    collects boards from many games to call it with. It has its own name
+    so that overriding either method does not hide the other.
+  */
+  virtual void evaluateBatch(const Board* const* boards, double* scores,
+                             int count)
+  {
+    for (int i = 0; i < count; ++i)
+    {
+      scores[i] = evaluate(*boards[i]);
+    }
+  }
+
  private:
 };
 
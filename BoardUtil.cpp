@@ -1,1173 +1,971 @@
 #include "sage/BoardUtil.h"
 
-namespace sage {
+#ifndef INCLUDED_sage_Attacks_h
+#include "sage/Attacks.h"
+#endif
 
-void BoardUtil::populateMoveList(const Board& board, MoveList& moveList)
-{
-  moveList.clear();
+#ifndef INCLUDED_sage_Exception_h
+#include "sage/Exception.h"
+#endif
 
-  MoveList tempMoveList;
+#ifndef INCLUDED_sage_Material_h
+#include "sage/Material.h"
+#endif
 
-  int pieceMask = ((board.getTurn() == Board::COLOR_white)
-                   ? Piece::PIECE_whiteAll
-                   : Piece::PIECE_blackAll);
+#ifndef INCLUDED_std_cstring
+#include <cstring>
+#define INCLUDED_std_cstring
+#endif
 
-  PieceList pieceList = board.getPieceList();
+#ifndef INCLUDED_std_sstream
+#include <sstream>
+#define INCLUDED_std_sstream
+#endif
 
-  // keep track of all squares being attacked by opponent
-  AttackMatrix isAttacked;
-  for (int i = 0; i < Board::NUM_COLUMNS; ++i)
-  {
-    for (int j = 0; j < Board::NUM_ROWS; ++j)
-    {
-      isAttacked[i][j] = 0;
-    }
-  }
+namespace sage {
 
-  // find my king on board. used to determine if I'm still in check after
-  // I make a move
-  Piece myKing;
-  for (PieceList::const_iterator iter = pieceList.begin();
-       iter != pieceList.end();
-       ++iter)
+namespace {
+
+  //! Offsets of each kind of piece from the first index of its color
+  enum PieceOffset
   {
-    if ((iter->getType() & pieceMask)
-        && (iter->getType() & static_cast<int>(Piece::PIECE_anyKing)))
-    {
-      myKing = *iter;
-      break;
-    }
+    OFFSET_king   = 0,
+    OFFSET_queen  = 1,
+    OFFSET_rook   = 2,
+    OFFSET_bishop = 3,
+    OFFSET_knight = 4,
+    OFFSET_pawn   = 5
+  };
+
+  /*!
+    \brief Returns the piece type of the given kind for a color
+    \param colorIndex Board::getColorIndex() of the color
+    \param offset Which kind of piece
+  */
+  Piece::Type getType(int colorIndex, PieceOffset offset)
+  {
+    return Piece::getTypeFromIndex((colorIndex * 6) + offset);
   }
 
-  // iterate through all pieces on board
-  for (PieceList::const_iterator iter = pieceList.begin();
-       iter != pieceList.end();
-       ++iter)
-  {
-    if (iter->getType() == Piece::PIECE_none)
-    {
-      continue;
-    }
+  //! Exchange values in centipawns by PieceOffset
+  const int PIECE_VALUES[6] = { 20000, 900, 500, 300, 300, 100 };
 
-    // populate isattacked for pieces of opposite color
-    if (!(iter->getType() & pieceMask))
-    {
-      isAttacked[iter->getColumn()][iter->getRow()]++;
-      continue;
-    }
+  //! Most captures an exchange can hold, one per piece on the board
+  const int MAX_EXCHANGE = 32;
 
-    if (iter->getType() & static_cast<int>(Piece::PIECE_anyKing))
-    {
-      populateKingAttacks(*iter, board, tempMoveList);
-    }
-    else if (iter->getType() & static_cast<int>(Piece::PIECE_anyQueen))
-    {
-      populateRookAttacks(*iter, board, tempMoveList);
-      populateBishopAttacks(*iter, board, tempMoveList);
-    }
-    else if (iter->getType() & static_cast<int>(Piece::PIECE_anyRook))
-    {
-      populateRookAttacks(*iter, board, tempMoveList);
-    }
-    else if (iter->getType() & static_cast<int>(Piece::PIECE_anyBishop))
-    {
-      populateBishopAttacks(*iter, board, tempMoveList);
-    }
-    else if (iter->getType() & static_cast<int>(Piece::PIECE_anyKnight))
-    {
-      populateKnightAttacks(*iter, board, tempMoveList);
-    }
-    else if (iter->getType() & static_cast<int>(Piece::PIECE_whitePawn))
-    {
-      populateWhitePawnMoves(*iter, board, tempMoveList);
-    }
-    else if (iter->getType() & static_cast<int>(Piece::PIECE_blackPawn))
-    {
-      populateBlackPawnMoves(*iter, board, tempMoveList);
-    }
-  }
+  //! FEN letters for each Piece::getIndex()
+  const char FEN_PIECES[] = "KQRBNPkqrbnp";
 
-  // filter out any illegal moves
-  for (MoveList::iterator iter = tempMoveList.begin();
-       iter != tempMoveList.end();
-       ++iter)
-  {
-    int col = iter->getEndColumn();
-    int row = iter->getEndRow();
+  //! Castling letters in FEN order, with the matching board flags
+  const char FEN_CASTLES[] = "KQkq";
+  const Board::StateFlag CASTLE_FLAGS[4] = { Board::FLAG_whiteKingCastle,
+                                             Board::FLAG_whiteQueenCastle,
+                                             Board::FLAG_blackKingCastle,
+                                             Board::FLAG_blackQueenCastle };
 
-    // is this move a capture?
-    Piece capturePiece = board.getPiece(col, row);
-    if (capturePiece.getType() != Piece::PIECE_none)
-    {
-      // can't capture own pieces!
-      if (capturePiece.getType() & pieceMask)
-      {
-        continue;
-      }
-      else
-      {
-        iter->setCapture(true);
-      }
-    }
+  /*!
+    \brief Appends one move per promotion piece to the move list
+  */
+  void addPromotions(MoveBuffer<>& moveList, int from, int to,
+                     bool capture)
+  {
+    const PackedMove::Flag flags[4] = { PackedMove::FLAG_queenPromotion,
+                                        PackedMove::FLAG_rookPromotion,
+                                        PackedMove::FLAG_bishopPromotion,
+                                        PackedMove::FLAG_knightPromotion };
 
-    // can't put own king in check!
-    // create temporary board, make this move on it, and check if we're in
-    // check still
-    if (moveInducesCheck(*iter, board, myKing))
+    for (int i = 0; i < 4; ++i)
     {
-      continue;
+      moveList.push_back(
+        PackedMove(from, to, static_cast<PackedMove::Flag>(
+                     flags[i] | (capture ? PackedMove::FLAG_capture : 0))));
     }
-
-    // add move to returned move list
-    moveList.push_back(*iter);
   }
 
-  // get castling moves
-  populateCastle(board, isAttacked, moveList);
+  const Bitboard COLUMN_A = 0x0101010101010101ULL;
+  const Bitboard COLUMN_H = 0x8080808080808080ULL;
+
+} // anonymous namespace
 
+void BoardUtil::populateMoveList(const Board& board, MoveList& moveList)
+{
+  MoveBuffer<> buffer;
+  populateMoveList(board, buffer);
+  convertMoveList(board, buffer, moveList);
 }
 
-void BoardUtil::populateAttackList(const Board& board, 
-                                   const Board::Color color, 
-                                   MoveList& moveList)
+void BoardUtil::populateMoveList(const Board& board, 
+                                 PackedMoveList& moveList)
 {
-  moveList.clear();
+  MoveBuffer<> buffer;
+  populateMoveList(board, buffer);
 
-  int pieceMask = ((color == Board::COLOR_white)
-                   ? Piece::PIECE_whiteAll
-                   : Piece::PIECE_blackAll);
+  moveList.assign(buffer.begin(), buffer.end());
+}
 
-  PieceList pieceList = board.getPieceList();
+void BoardUtil::populateMoveList(const Board& board,
+                                 MoveBuffer<>& moveList)
+{
+  bool check;
+  populateMoveList(board, moveList, check);
+}
 
-  // iterate through all pieces on board
-  for (PieceList::const_iterator iter = pieceList.begin();
-       iter != pieceList.end();
-       ++iter)
-  {
-    // skip pieces of wrong color
-    if (!(iter->getType() & pieceMask))
-    {
-      continue;
-    }
+void BoardUtil::populateMoveList(const Board& board,
+                                 MoveBuffer<>& moveList,
+                                 bool& check)
+{
+  moveList.clear();
 
-    if (iter->getType() & static_cast<int>(Piece::PIECE_anyKing))
-    {
-      populateKingAttacks(*iter, board, moveList);
-    }
-    else if (iter->getType() & static_cast<int>(Piece::PIECE_anyQueen))
-    {
-      populateRookAttacks(*iter, board, moveList);
-      populateBishopAttacks(*iter, board, moveList);
-    }
-    else if (iter->getType() & static_cast<int>(Piece::PIECE_anyRook))
-    {
-      populateRookAttacks(*iter, board, moveList);
-    }
-    else if (iter->getType() & static_cast<int>(Piece::PIECE_anyBishop))
-    {
-      populateBishopAttacks(*iter, board, moveList);
-    }
-    else if (iter->getType() & static_cast<int>(Piece::PIECE_anyKnight))
-    {
-      populateKnightAttacks(*iter, board, moveList);
-    }
-    else if (iter->getType() & static_cast<int>(Piece::PIECE_whitePawn))
-    {
-      populateWhitePawnAttacks(*iter, board, moveList);
-    }
-    else if (iter->getType() & static_cast<int>(Piece::PIECE_blackPawn))
-    {
-      populateBlackPawnAttacks(*iter, board, moveList);
-    }
-  }
+  MoveContext context;
+  getMoveContext(board, context);
+  check = (context.m_checkers != 0);
+
+  populateMoves(board, context, MOVES_all, ~0ULL, moveList);
 }
 
-void BoardUtil::populateKingAttacks(const Piece& piece,
-                                    const Board& board, 
-                                    MoveList& moveList)
+void BoardUtil::populateMoveList(const Board& board,
+                                 MoveKind kind,
+                                 MoveBuffer<>& moveList)
 {
-  int col = piece.getColumn();
-  int row = piece.getRow();
-
-  // This is the move we're going to add
-  Move move;
-  move.setStartColumn(col);
-  move.setStartRow(row);
-  move.setPiece(piece);
+  moveList.clear();
 
+  MoveContext context;
+  getMoveContext(board, context);
 
-  move.setEndColumn(col);
-  if (row > 0)
-  {
-    // Moving king to S
-    move.setEndRow(row - 1);
-    moveList.push_back(move);
-  }
-  
-  if (row < (Board::NUM_ROWS - 1))
-  {
-    // Moving king to N
-    move.setEndRow(row + 1);
-    moveList.push_back(move);
-  }
+  populateMoves(board, context, kind, ~0ULL, moveList);
+}
 
-  move.setEndRow(row);
-  if (col > 0)
-  {
-    // Moving king to W
-    move.setEndColumn(col - 1);
-    moveList.push_back(move);
+bool BoardUtil::isLegalMove(const Board& board, PackedMove move)
+{
+  MoveContext context;
+  getMoveContext(board, context);
 
-    if (row > 0)
-    {
-      // Moving king to SW
-      move.setEndRow(row - 1);
-      moveList.push_back(move);
-    }
-    
-    if (row < (Board::NUM_ROWS - 1))
-    {
-      // Moving king to NW
-      move.setEndRow(row + 1);
-      moveList.push_back(move);
-    }
-  }
+  // only the moves of the piece on the start square need generating
+  MoveBuffer<> moveList;
+  populateMoves(board, context, MOVES_all,
+                BitboardUtil::getMask(move.getFrom()), moveList);
 
-  move.setEndRow(row);
-  if (col < (Board::NUM_COLUMNS - 1))
+  for (MoveBuffer<>::const_iterator iter = moveList.begin();
+       iter != moveList.end();
+       ++iter)
   {
-    // Moving king to E
-    move.setEndColumn(col + 1);
-    moveList.push_back(move);
-
-    if (row > 0)
-    {
-      // Moving king to SE
-      move.setEndRow(row - 1);
-      moveList.push_back(move);
-    }
-    
-    if (row < (Board::NUM_ROWS - 1))
+    if (*iter == move)
     {
-      // Moving king to SW
-      move.setEndRow(row + 1);
-      moveList.push_back(move);
+      return true;
     }
   }
-}
 
+  return false;
+}
 
-void BoardUtil::populateRookAttacks(const Piece& piece,
-                                    const Board& board, 
-                                    MoveList& moveList)
+void BoardUtil::populateMoves(const Board& board,
+                              const MoveContext& context,
+                              MoveKind kind,
+                              Bitboard from,
+                              MoveBuffer<>& moveList)
 {
-  int col = piece.getColumn();
-  int row = piece.getRow();
+  const int us = Board::getColorIndex(board.getTurn());
+  const Bitboard opponentPieces = board.getOccupied(board.getOppositeTurn());
 
-  // This is the move we're going to add
-  Move move;
-  move.setStartColumn(col);
-  move.setStartRow(row);
-  move.setPiece(piece);
-  move.setEndRow(row);
+  // the squares the moves asked for may land on; pawns sort their own
+  // moves, since promotions are tactical wherever they land
+  Bitboard landing = 0;
+  if (kind & MOVES_tactical)
+  {
+    landing |= opponentPieces;
+  }
+  if (kind & MOVES_quiet)
+  {
+    landing |= ~opponentPieces;
+  }
 
-  // Add moves to the EAST
-  for (int i = col + 1; i < Board::NUM_COLUMNS; ++i)
+  if ((context.m_kingSquare >= 0)
+      && (from & BitboardUtil::getMask(context.m_kingSquare)))
   {
-    move.setEndColumn(i);
-    moveList.push_back(move);
-    if (board.getPiece(move.getEndColumn(), move.getEndRow()).getType()
-        != Piece::PIECE_none)
-    {
-      break;
-    }
+    populateTargets(context.m_kingSquare, context.m_kingTargets & landing,
+                    opponentPieces, moveList);
   }
 
-  // Add moves to the WEST
-  for (int i = col - 1; i >= 0; --i)
+  // in double check only the king can move
+  if (context.m_checkers & (context.m_checkers - 1))
   {
-    move.setEndColumn(i);
-    moveList.push_back(move);
-    if (board.getPiece(move.getEndColumn(), move.getEndRow()).getType()
-        != Piece::PIECE_none)
-    {
-      break;
-    }
+    return;
   }
 
-  move.setEndColumn(col);
+  populatePawnMoves(board, board.getPieces(getType(us, OFFSET_pawn)) & from,
+                    kind, context.m_kingSquare, context.m_checkers,
+                    context.m_pinned, context.m_targets, moveList);
 
-  // Add moves to the NORTH
-  for (int i = row + 1; i < Board::NUM_ROWS; ++i)
+  // queens, rooks, bishops and knights
+  for (int offset = OFFSET_queen; offset <= OFFSET_knight; ++offset)
   {
-    move.setEndRow(i);
-    moveList.push_back(move);
-    if (board.getPiece(move.getEndColumn(), move.getEndRow()).getType()
-        != Piece::PIECE_none)
+    Bitboard pieces = (board.getPieces(getType(us, PieceOffset(offset)))
+                       & from);
+    while (pieces)
     {
-      break;
+      int square = BitboardUtil::popFirstSquare(pieces);
+      populateTargets(square,
+                      getPieceTargets(board, context, offset, square)
+                      & landing,
+                      opponentPieces, moveList);
     }
   }
 
-  // Add moves to the SOUTH
-  for (int i = row - 1; i >= 0; --i)
+  // get castling moves
+  if ((kind & MOVES_quiet) && (context.m_kingSquare >= 0)
+      && (from & BitboardUtil::getMask(context.m_kingSquare))
+      && !context.m_checkers)
   {
-    move.setEndRow(i);
-    moveList.push_back(move);
-    if (board.getPiece(move.getEndColumn(), move.getEndRow()).getType()
-        != Piece::PIECE_none)
-    {
-      break;
-    }
+    populateCastle(board, context.m_attacked, moveList);
   }
 }
 
-void BoardUtil::populateBishopAttacks(const Piece& piece,
-                                      const Board& board, 
-                                      MoveList& moveList)
+bool BoardUtil::hasLegalMove(const Board& board)
 {
-  int col = piece.getColumn();
-  int row = piece.getRow();
-
-  // This is the move we're going to add
-  Move move;
-  move.setStartColumn(col);
-  move.setStartRow(row);
-  move.setPiece(piece);
+  MoveContext context;
+  getMoveContext(board, context);
 
-  // Add moves to the NORTHEAST
-  for (int i = col + 1, j = row + 1; 
-       (i < Board::NUM_COLUMNS) && (j < Board::NUM_ROWS);
-       ++i, ++j)
+  // the king is the cheapest to test and most often has a move
+  if (context.m_kingTargets)
   {
-    move.setEndColumn(i);
-    move.setEndRow(j);
-
-    moveList.push_back(move);
-    if (board.getPiece(move.getEndColumn(), move.getEndRow()).getType()
-        != Piece::PIECE_none)
-    {
-      break;
-    }
+    return true;
   }
 
-  // Add moves to the NORTHWEST
-  for (int i = col - 1, j = row + 1; 
-       (i >= 0) && (j < Board::NUM_ROWS);
-       --i, ++j)
+  if (context.m_checkers & (context.m_checkers - 1))
   {
-    move.setEndColumn(i);
-    move.setEndRow(j);
-
-    moveList.push_back(move);
-    if (board.getPiece(move.getEndColumn(), move.getEndRow()).getType()
-        != Piece::PIECE_none)
-    {
-      break;
-    }
+    return false;
   }
 
-  // Add moves to the SOUTHEAST
-  for (int i = col + 1, j = row - 1; 
-       (i < Board::NUM_COLUMNS) && (j >= 0);
-       ++i, --j)
+  const int us = Board::getColorIndex(board.getTurn());
+  for (int offset = OFFSET_queen; offset <= OFFSET_knight; ++offset)
   {
-    move.setEndColumn(i);
-    move.setEndRow(j);
-
-    moveList.push_back(move);
-    if (board.getPiece(move.getEndColumn(), move.getEndRow()).getType()
-        != Piece::PIECE_none)
+    Bitboard pieces = board.getPieces(getType(us, 
+                                              PieceOffset(offset)));
+    while (pieces)
     {
-      break;
+      if (getPieceTargets(board, context, offset,
+                          BitboardUtil::popFirstSquare(pieces)))
+      {
+        return true;
+      }
     }
   }
 
-  // Add moves to the SOUTHWEST
-  for (int i = col - 1, j = row - 1; 
-       (i >= 0) && (j >= 0);
-       --i, --j)
-  {
-    move.setEndColumn(i);
-    move.setEndRow(j);
-
-    moveList.push_back(move);
-    if (board.getPiece(move.getEndColumn(), move.getEndRow()).getType()
-        != Piece::PIECE_none)
-    {
-      break;
-    }
-  }
+  // castling is never the only legal move: if it is legal, so is the
+  // king's step towards the rook, which was already tested
+  MoveBuffer<> moveList;
+  populatePawnMoves(board, board.getPieces(getType(us, OFFSET_pawn)),
+                    MOVES_all, context.m_kingSquare, context.m_checkers,
+                    context.m_pinned, context.m_targets, moveList);
+  return !moveList.empty();
 }
 
-void BoardUtil::populateKnightAttacks(const Piece& piece,
-                                      const Board& board, 
-                                      MoveList& moveList)
+int BoardUtil::countLegalMoves(const Board& board)
 {
-  int col = piece.getColumn();
-  int row = piece.getRow();
+  MoveContext context;
+  getMoveContext(board, context);
 
-  // This is the move we're going to add
-  Move move;
-  move.setStartColumn(col);
-  move.setStartRow(row);
-  move.setPiece(piece);
+  int count = BitboardUtil::popCount(context.m_kingTargets);
 
-  if (col > 0)
+  if (context.m_checkers & (context.m_checkers - 1))
   {
-    if (row > 1)
-    {
-      // Knight move to SSW
-      move.setEndColumn(col - 1);
-      move.setEndRow(row - 2);
-      moveList.push_back(move);
-    }
-
-    if (row < (Board::NUM_ROWS - 2))
-    {
-      // Knight move to NNW
-      move.setEndColumn(col - 1);
-      move.setEndRow(row + 2);
-      moveList.push_back(move);
-    }
+    return count;
   }
 
-  if (col > 1)
+  const int us = Board::getColorIndex(board.getTurn());
+  for (int offset = OFFSET_queen; offset <= OFFSET_knight; ++offset)
   {
-    if (row > 0)
+    Bitboard pieces = board.getPieces(getType(us, 
+                                              PieceOffset(offset)));
+    while (pieces)
     {
-      // Knight move to WWS
-      move.setEndColumn(col - 2);
-      move.setEndRow(row - 1);
-      moveList.push_back(move);
-    }
-
-    if (row < (Board::NUM_ROWS - 1))
-    {
-      // Knight move to WWN
-      move.setEndColumn(col - 2);
-      move.setEndRow(row + 1);
-      moveList.push_back(move);
+      count += BitboardUtil::popCount(
+        getPieceTargets(board, context, offset,
+                        BitboardUtil::popFirstSquare(pieces)));
     }
   }
 
-  if (col < (Board::NUM_COLUMNS - 1))
+  // pawn moves and castling come in too many flavors to count from a
+  // bitboard, so they are generated
+  MoveBuffer<> moveList;
+  populatePawnMoves(board, board.getPieces(getType(us, OFFSET_pawn)),
+                    MOVES_all, context.m_kingSquare, context.m_checkers,
+                    context.m_pinned, context.m_targets, moveList);
+  if ((context.m_kingSquare >= 0) && !context.m_checkers)
   {
-    if (row > 1)
-    {
-      // Knight move to SSE
-      move.setEndColumn(col + 1);
-      move.setEndRow(row - 2);
-      moveList.push_back(move);
-    }
-
-    if (row < (Board::NUM_ROWS - 2))
-    {
-      // Knight move to NNE
-      move.setEndColumn(col + 1);
-      move.setEndRow(row + 2);
-      moveList.push_back(move);
-    }
+    populateCastle(board, context.m_attacked, moveList);
   }
 
-  if (col < (Board::NUM_COLUMNS - 2))
+  return count + moveList.size();
+}
+
+void BoardUtil::getMoveContext(const Board& board, MoveContext& context)
+{
+  const int us = Board::getColorIndex(board.getTurn());
+  const Bitboard occupied = board.getOccupied();
+  const Bitboard myPieces = board.getOccupied(board.getTurn());
+  const Bitboard opponentPieces = board.getOccupied(board.getOppositeTurn());
+
+  // find my king on board. everything else is measured against it: which
+  // of my pieces are pinned to it and which enemy pieces are checking it
+  Bitboard myKing = board.getPieces(getType(us, OFFSET_king));
+  context.m_kingSquare = -1;
+  context.m_checkers = 0;
+  context.m_pinned = 0;
+  context.m_kingTargets = 0;
+
+  // every square the opponent attacks. my king is taken off the board so
+  // that it doesn't hide squares behind it on the line of a checking
+  // slider; the king may step onto none of these squares
+  context.m_attacked = getAttackMap(board, board.getOppositeTurn(),
+                                    occupied & ~myKing);
+
+  if (myKing)
   {
-    if (row > 0)
+    context.m_kingSquare = BitboardUtil::getFirstSquare(myKing);
+    if (context.m_attacked & myKing)
     {
-      // Knight move to EES
-      move.setEndColumn(col + 2);
-      move.setEndRow(row - 1);
-      moveList.push_back(move);
+      context.m_checkers = (getAttackers(board, context.m_kingSquare,
+                                         occupied)
+                            & opponentPieces);
     }
+    context.m_pinned = getPinned(board, context.m_kingSquare);
+    context.m_kingTargets = (Attacks::getKingAttacks(context.m_kingSquare)
+                             & ~myPieces
+                             & ~context.m_attacked);
+  }
 
-    if (row < (Board::NUM_ROWS - 1))
-    {
-      // Knight move to EEN
-      move.setEndColumn(col + 2);
-      move.setEndRow(row + 1);
-      moveList.push_back(move);
-    }
+  // squares that the other pieces may move to. in single check a move has
+  // to capture the checker or block the line between it and my king
+  context.m_targets = ~myPieces;
+  if (context.m_checkers)
+  {
+    context.m_targets 
+      = (Attacks::getBetween(context.m_kingSquare,
+                             BitboardUtil::getFirstSquare(context.m_checkers))
+         | context.m_checkers);
   }
 }
 
-void BoardUtil::populateWhitePawnMoves(const Piece& piece,
-                                       const Board& board, 
-                                       MoveList& moveList)
+Bitboard BoardUtil::getPieceTargets(const Board& board,
+                                    const MoveContext& context,
+                                    int offset,
+                                    int from)
 {
-  int col = piece.getColumn();
-  int row = piece.getRow();
+  const Bitboard occupied = board.getOccupied();
+  Bitboard attacks;
 
-  // This is the move we're going to add
-  Move move;
-  move.setStartColumn(col);
-  move.setStartRow(row);
-  move.setPiece(piece);
-  move.setEndColumn(col);
-
-  // pawn can move ahead one square
-  if (board.isEmpty(col, row + 1))
+  switch (offset)
   {
-    move.setEndRow(row + 1);
-
-    // if this move puts us on the last rank, then we add all promotions
-    if (row == (Board::NUM_ROWS - 2))
-    {
-      move.setPromotionType(Piece::PIECE_whiteBishop);
-      moveList.push_back(move);
-
-      move.setPromotionType(Piece::PIECE_whiteKnight);
-      moveList.push_back(move);
-
-      move.setPromotionType(Piece::PIECE_whiteQueen);
-      moveList.push_back(move);
+    case OFFSET_queen:
+      attacks = Attacks::getQueenAttacks(from, occupied);
+      break;
+    case OFFSET_rook:
+      attacks = Attacks::getRookAttacks(from, occupied);
+      break;
+    case OFFSET_bishop:
+      attacks = Attacks::getBishopAttacks(from, occupied);
+      break;
+    default:
+      attacks = Attacks::getKnightAttacks(from);
+      break;
+  }
 
-      move.setPromotionType(Piece::PIECE_whiteRook);
-      moveList.push_back(move);
-    }
-    else
-    {
-      moveList.push_back(move);
-    }
+  attacks &= context.m_targets;
 
-    // if we're on the second rank, then we can move ahead 2 
-    if ((row == 1) && board.isEmpty(col, row + 2))
-    {
-      move.setEndRow(row + 2);
-      moveList.push_back(move);
-    }
+  // a pinned piece may only move along the pin line. no knight move stays
+  // on a line through its square, so a pinned knight is left with nothing
+  if (context.m_pinned & BitboardUtil::getMask(from))
+  {
+    attacks &= Attacks::getLine(context.m_kingSquare, from);
   }
-}
 
+  return attacks;
+}
 
-void BoardUtil::populateBlackPawnMoves(const Piece& piece,
-                                       const Board& board, 
-                                       MoveList& moveList)
+Bitboard BoardUtil::getAttackers(const Board& board, 
+                                 int square, 
+                                 Bitboard occupied)
 {
-  int col = piece.getColumn();
-  int row = piece.getRow();
-
-  // This is the move we're going to add
-  Move move;
-  move.setStartColumn(col);
-  move.setStartRow(row);
-  move.setPiece(piece);
-  move.setEndColumn(col);
+  Bitboard bishops = (board.getPieces(Piece::PIECE_whiteBishop)
+                      | board.getPieces(Piece::PIECE_blackBishop)
+                      | board.getPieces(Piece::PIECE_whiteQueen)
+                      | board.getPieces(Piece::PIECE_blackQueen));
+  Bitboard rooks = (board.getPieces(Piece::PIECE_whiteRook)
+                    | board.getPieces(Piece::PIECE_blackRook)
+                    | board.getPieces(Piece::PIECE_whiteQueen)
+                    | board.getPieces(Piece::PIECE_blackQueen));
+
+  // a pawn attacks the square if a pawn of the other color standing on
+  // the square would attack it back
+  return ((Attacks::getPawnAttacks(1, square)
+           & board.getPieces(Piece::PIECE_whitePawn))
+          | (Attacks::getPawnAttacks(0, square)
+             & board.getPieces(Piece::PIECE_blackPawn))
+          | (Attacks::getKnightAttacks(square)
+             & (board.getPieces(Piece::PIECE_whiteKnight)
+                | board.getPieces(Piece::PIECE_blackKnight)))
+          | (Attacks::getKingAttacks(square)
+             & (board.getPieces(Piece::PIECE_whiteKing)
+                | board.getPieces(Piece::PIECE_blackKing)))
+          | (Attacks::getBishopAttacks(square, occupied) & bishops)
+          | (Attacks::getRookAttacks(square, occupied) & rooks));
+}
 
-  // pawn can move ahead one square
-  if (board.isEmpty(col, row - 1))
+Bitboard BoardUtil::getPinned(const Board& board, int kingSquare)
+{
+  const int them = Board::getColorIndex(board.getOppositeTurn());
+  const Bitboard occupied = board.getOccupied();
+  const Bitboard myPieces = board.getOccupied(board.getTurn());
+  const Bitboard queens = board.getPieces(getType(them, OFFSET_queen));
+
+  // enemy sliders that would attack my king if nothing were in the way
+  Bitboard snipers 
+    = ((Attacks::getRookAttacks(kingSquare, 0)
+        & (board.getPieces(getType(them, OFFSET_rook)) | queens))
+       | (Attacks::getBishopAttacks(kingSquare, 0)
+          & (board.getPieces(getType(them, OFFSET_bishop)) | queens)));
+
+  // a piece is pinned if it is the only thing between a sniper and my king
+  Bitboard pinned = 0;
+  while (snipers)
   {
-    move.setEndRow(row - 1);
-
-    // if this move puts us on the first rank, then we add all promotions
-    if (row == 1)
-    {
-      move.setPromotionType(Piece::PIECE_blackBishop);
-      moveList.push_back(move);
+    int sniper = BitboardUtil::popFirstSquare(snipers);
+    Bitboard blockers = (Attacks::getBetween(kingSquare, sniper) & occupied);
 
-      move.setPromotionType(Piece::PIECE_blackKnight);
-      moveList.push_back(move);
-
-      move.setPromotionType(Piece::PIECE_blackQueen);
-      moveList.push_back(move);
-
-      move.setPromotionType(Piece::PIECE_blackRook);
-      moveList.push_back(move);
-    }
-    else
+    if (blockers && !(blockers & (blockers - 1)))
     {
-      moveList.push_back(move);
-    }
-
-    // if we're on the seventh rank, then we can move ahead 2 
-    if ((row == 6) && board.isEmpty(col, row - 2))
-    {
-      move.setEndRow(row - 2);
-      moveList.push_back(move);
+      pinned |= (blockers & myPieces);
     }
   }
+
+  return pinned;
 }
 
-void BoardUtil::populateWhitePawnAttacks(const Piece& piece,
-                                         const Board& board, 
-                                         MoveList& moveList)
+void BoardUtil::populateAttackList(const Board& board, 
+                                   const Board::Color color, 
+                                   MoveList& moveList)
 {
-  int col = piece.getColumn();
-  int row = piece.getRow();
+  moveList.clear();
 
-  // This is the move we're going to add
-  Move move;
-  move.setStartColumn(col);
-  move.setStartRow(row);
-  move.setPiece(piece);
+  const int us = Board::getColorIndex(color);
+  const Bitboard occupied = board.getOccupied();
 
-  // capturing to the WEST
-  if (col > 0)
+  for (int offset = OFFSET_king; offset <= OFFSET_pawn; ++offset)
   {
-    move.setEndColumn(col - 1);
-    move.setEndRow(row + 1);
-    moveList.push_back(move);
-  }
+    Piece::Type type = getType(us, PieceOffset(offset));
+    Bitboard pieces = board.getPieces(type);
+    while (pieces)
+    {
+      int square = BitboardUtil::popFirstSquare(pieces);
+      Bitboard targets;
 
-  // capturing to the EAST
-  if (col < (Board::NUM_COLUMNS - 1))
-  {
-    move.setEndColumn(col + 1);
-    move.setEndRow(row + 1);
-    moveList.push_back(move);
+      switch (offset)
+      {
+      case OFFSET_king:
+        targets = Attacks::getKingAttacks(square);
+        break;
+      case OFFSET_queen:
+        targets = Attacks::getQueenAttacks(square, occupied);
+        break;
+      case OFFSET_rook:
+        targets = Attacks::getRookAttacks(square, occupied);
+        break;
+      case OFFSET_bishop:
+        targets = Attacks::getBishopAttacks(square, occupied);
+        break;
+      case OFFSET_knight:
+        targets = Attacks::getKnightAttacks(square);
+        break;
+      default:
+        targets = Attacks::getPawnAttacks(us, square);
+        break;
+      }
+
+      populateTargets(Piece(BitboardUtil::getColumn(square),
+                            BitboardUtil::getRow(square), type),
+                      targets, moveList);
+    }
   }
 }
 
-void BoardUtil::populateBlackPawnAttacks(const Piece& piece,
-                                         const Board& board, 
-                                         MoveList& moveList)
+void BoardUtil::populateTargets(const Piece& piece,
+                                Bitboard targets,
+                                MoveList& moveList)
 {
-  int col = piece.getColumn();
-  int row = piece.getRow();
-
   // This is the move we're going to add
   Move move;
-  move.setStartColumn(col);
-  move.setStartRow(row);
+  move.setStartColumn(piece.getColumn());
+  move.setStartRow(piece.getRow());
   move.setPiece(piece);
 
-  // capturing to the WEST
-  if (col > 0)
-  {
-    move.setEndColumn(col - 1);
-    move.setEndRow(row - 1);
-    moveList.push_back(move);
-  }
-
-  // capturing to the EAST
-  if (col < (Board::NUM_COLUMNS - 1))
+  while (targets)
   {
-    move.setEndColumn(col + 1);
-    move.setEndRow(row - 1);
+    int square = BitboardUtil::popFirstSquare(targets);
+    move.setEndColumn(BitboardUtil::getColumn(square));
+    move.setEndRow(BitboardUtil::getRow(square));
     moveList.push_back(move);
   }
 }
 
-
-
-void BoardUtil::populateCastle(
-  const Board& board, 
-  int isAttacked[Board::NUM_COLUMNS][Board::NUM_ROWS],
-  MoveList& moveList)
-{
-  // add castling moves: The king cannot be in check currently and cannot
-  // be in check during any part of the castling maneuver
-  if (board.getTurn() == Board::COLOR_white)
-  {
-    if (board.getWhiteQueenCastle()
-        && (board.getPiece(3, 0).getType() == Piece::PIECE_none)
-        && (board.getPiece(2, 0).getType() == Piece::PIECE_none)
-        && !isAttacked[4][0]
-        && !isAttacked[3][0]
-        && !isAttacked[2][0])
-    {
-      Move move;
-      move.setStartColumn(4);
-      move.setStartRow(0);
-      move.setPiece(board.getPiece(4, 0));
-      move.setEndColumn(2);
-      move.setEndRow(0);
-      moveList.push_back(move);
-    }
-
-    if (board.getWhiteKingCastle()
-        && (board.getPiece(5, 0).getType() == Piece::PIECE_none)
-        && (board.getPiece(6, 0).getType() == Piece::PIECE_none)
-        && !isAttacked[4][0]
-        && !isAttacked[5][0]
-        && !isAttacked[6][0])
-    {   
-      Move move;
-      move.setStartColumn(4);
-      move.setStartRow(0);
-      move.setPiece(board.getPiece(4, 0));
-      move.setEndColumn(6);
-      move.setEndRow(0);
-      moveList.push_back(move);
-    }    
-  }
-  else
-  {
-    if (board.getBlackQueenCastle()
-        && (board.getPiece(3, Board::NUM_ROWS - 1).getType()
-            == Piece::PIECE_none)
-        && (board.getPiece(2, Board::NUM_ROWS - 1).getType()
-            == Piece::PIECE_none)
-        && !isAttacked[4][Board::NUM_ROWS - 1]
-        && !isAttacked[3][Board::NUM_ROWS - 1]
-        && !isAttacked[2][Board::NUM_ROWS - 1])
-    {   
-      Move move;
-      move.setStartColumn(4);
-      move.setStartRow(Board::NUM_ROWS - 1);
-      move.setPiece(board.getPiece(4, Board::NUM_ROWS - 1));
-      move.setEndColumn(2);
-      move.setEndRow(Board::NUM_ROWS - 1);
-      moveList.push_back(move);
-    }
-
-    if (board.getBlackKingCastle()
-        && (board.getPiece(5, Board::NUM_ROWS - 1).getType()
-            == Piece::PIECE_none)
-        && (board.getPiece(6, Board::NUM_ROWS - 1).getType()
-            == Piece::PIECE_none)
-        && !isAttacked[4][Board::NUM_ROWS - 1]
-        && !isAttacked[5][Board::NUM_ROWS - 1]
-        && !isAttacked[6][Board::NUM_ROWS - 1])
-    {   
-      Move move;
-      move.setStartColumn(4);
-      move.setStartRow(Board::NUM_ROWS - 1);
-      move.setPiece(board.getPiece(4, Board::NUM_ROWS - 1));
-      move.setEndColumn(6);
-      move.setEndRow(Board::NUM_ROWS - 1);
-      moveList.push_back(move);
-    }    
-  }
-}
-
-bool BoardUtil::moveInducesCheck(const Move& move, 
-                                 const Board& board, 
-                                 const Piece& myKing)
+void BoardUtil::populateTargets(int from,
+                                Bitboard targets,
+                                Bitboard opponentPieces,
+                                MoveBuffer<>& moveList)
 {
-  Board tempBoard(board);
-  tempBoard.applyMove(move);
-  MoveList moveList;
-  BoardUtil::populateAttackList(tempBoard, tempBoard.getTurn(), moveList);
-  for (MoveList::const_iterator iter = moveList.begin();
-       iter != moveList.end();
-       ++iter)
+  while (targets)
   {
-    if ((iter->getEndColumn() == myKing.getColumn())
-        && (iter->getEndRow() == myKing.getRow()))
-    {
-      return true;
-    }
+    int to = BitboardUtil::popFirstSquare(targets);
+    moveList.push_back(PackedMove(from, to,
+                                  (opponentPieces & BitboardUtil::getMask(to))
+                                  ? PackedMove::FLAG_capture
+                                  : PackedMove::FLAG_quiet));
   }
-
-  return false;
 }
 
-#if 0
-bool BoardUtil::moveInducesCheck(const Move& move, 
-                                 const AttackMatrix& isAttacked,
-                                 const Board& board, 
-                                 const Piece& myKing)
+void BoardUtil::populatePawnMoves(const Board& board,
+                                  Bitboard pawns,
+                                  MoveKind kind,
+                                  int kingSquare,
+                                  Bitboard checkers,
+                                  Bitboard pinned,
+                                  Bitboard targets,
+                                  MoveBuffer<>& moveList)
 {
-  // the starting location of the piece that's moving
-  int pieceColumn = move.getStartColumn();
-  int pieceRow = move.getStartRow();
-
-  // the location of my king
-  int kingColumn = myKing.getColumn();
-  int kingRow = myKing.getRow();
-
-  // if it's my king that's moving, then we just check if it's final
-  // destination is attacked
-  if (move.getPiece().getType() & static_cast<int>(Piece::PIECE_anyKing))
+  const int us = Board::getColorIndex(board.getTurn());
+  const int them = 1 - us;
+  const Bitboard occupied = board.getOccupied();
+  const Bitboard opponentPieces = board.getOccupied(board.getOppositeTurn());
+
+  // white pawns move up the board and black pawns down
+  const int forward = (us ? -8 : 8);
+  const int startRow = (us ? 6 : 1);
+  const int promotionRow = (us ? 0 : 7);
+
+  // en passant target square and the square of the pawn it captures
+  int epSquare = -1;
+  int epCapture = -1;
+  if (board.getEnPassantColumn() >= 0)
   {
-    return isAttacked[move.getEndColumn()][move.getEndRow()];
-  }
-
-  // The move can put my king in check only if the moving piece is being
-  // attacked by the enemy 
-  if (!isAttacked[pieceColumn][pieceRow])
-  {
-    return false;
-  }
-
-  // my king has to be on the same column, row, or diagonal for this to 
-  // put me in check
-
-  // COLUMN
-  ////////////////////////////////////////////////////////////////////////
-  if (kingColumn == pieceColumn)
-  {
-    // if the piece is not moving off this column, then it's not putting
-    // the king in check
-    if (pieceColumn == move.getEndColumn())
-    {
-      return false;
-    }
-
-    // this is a mask for lateral attackers of the opposite color
-    int mask = 0;
-    if (myKing.getType() == Piece::PIECE_whiteKing)
-    {
-      mask = (static_cast<int>(Piece::PIECE_blackRook)
-              | static_cast<int>(Piece::PIECE_blackQueen));
-    }
-    else
-    {
-      mask = (static_cast<int>(Piece::PIECE_whiteRook)
-              | static_cast<int>(Piece::PIECE_whiteQueen));
-    }
-
-    if (kingRow > pieceRow)
-    {
-      // in order to induce check, there can't be anything between my piece
-      // and the king      
-      for (int i = pieceRow + 1; i < kingRow; ++i)
-      {
-        if (board.getPiece(pieceColumn, i).getType() != Piece::PIECE_none)
-        {
-          return false;
-        }
-      }
-
-      // then, on the other side of my piece, there must be a rook or queen
-      for (int i = pieceRow - 1; i >= 0; --i)
-      {
-        Piece::Type otherPieceType = board.getPiece(pieceColumn, i).getType();
-        if (otherPieceType != Piece::PIECE_none)
-        {
-          return (otherPieceType & mask);
-        }        
-      }
-      
-      // we must not have found an attacker lurking, so this move won't 
-      // put is in check
-      return false;
-    }
-    else
-    {
-      // in order to induce check, there can't be anything between my piece
-      // and the king      
-      for (int i = kingRow + 1; i < pieceRow; ++i)
-      {
-        if (board.getPiece(pieceColumn, i).getType() != Piece::PIECE_none)
-        {
-          return false;
-        }
-      }
-
-      // then, on the other side of my piece, there must be a rook or queen
-      for (int i = pieceRow + 1; i < Board::NUM_ROWS; ++i)
-      {
-        Piece::Type otherPieceType = board.getPiece(pieceColumn, i).getType();
-        if (otherPieceType != Piece::PIECE_none)
-        {
-          return (otherPieceType & mask);
-        }
-      }
-      
-      // we must not have found an attacker lurking, so this move won't 
-      // put is in check
-      return false;
-    }
+    epSquare = BitboardUtil::getSquare(board.getEnPassantColumn(),
+                                       us ? 2 : 5);
+    epCapture = epSquare - forward;
   }
-  // ROW
-  ////////////////////////////////////////////////////////////////////////
-  else if (kingRow == pieceRow)
+
+  while (pawns)
   {
-    // if the piece is not moving off this row, then it's not putting
-    // the king in check
-    if (pieceRow == move.getEndRow())
-    {
-      return false;
-    }
+    int from = BitboardUtil::popFirstSquare(pawns);
 
-    // this is a mask for lateral attackers of the opposite color
-    int mask = 0;
-    if (myKing.getType() == Piece::PIECE_whiteKing)
-    {
-      mask = (static_cast<int>(Piece::PIECE_blackRook)
-              | static_cast<int>(Piece::PIECE_blackQueen));
-    }
-    else
+    // a pinned pawn may only move along the pin line
+    Bitboard allowed = targets;
+    if (pinned & BitboardUtil::getMask(from))
     {
-      mask = (static_cast<int>(Piece::PIECE_whiteRook)
-              | static_cast<int>(Piece::PIECE_whiteQueen));
+      allowed &= Attacks::getLine(kingSquare, from);
     }
 
-    if (kingColumn > pieceColumn)
+    // pushes; a promotion is tactical even when it captures nothing
+    int to = from + forward;
+    if (!(occupied & BitboardUtil::getMask(to)))
     {
-      // in order to induce check, there can't be anything between my piece
-      // and the king      
-      for (int i = pieceColumn + 1; i < kingColumn; ++i)
+      if (allowed & BitboardUtil::getMask(to))
       {
-        if (board.getPiece(i, pieceRow).getType() != Piece::PIECE_none)
+        if (BitboardUtil::getRow(to) == promotionRow)
         {
-          return false;
+          if (kind & MOVES_tactical)
+          {
+            addPromotions(moveList, from, to, false);
+          }
         }
-      }
-
-      // then, on the other side of my piece, there must be a rook or queen
-      for (int i = pieceColumn - 1; i >= 0; --i)
-      {
-        Piece::Type otherPieceType = board.getPiece(i, pieceRow).getType();
-        if (otherPieceType != Piece::PIECE_none)
-        {
-          return (otherPieceType & mask);
-        }        
-      }
-      
-      // we must not have found an attacker lurking, so this move won't 
-      // put is in check
-      return false;
-    }
-    else
-    {
-      // in order to induce check, there can't be anything between my piece
-      // and the king      
-      for (int i = kingColumn + 1; i < pieceColumn; ++i)
-      {
-        if (board.getPiece(i, pieceRow).getType() != Piece::PIECE_none)
+        else if (kind & MOVES_quiet)
         {
-          return false;
+          moveList.push_back(PackedMove(from, to, PackedMove::FLAG_quiet));
         }
       }
 
-      // then, on the other side of my piece, there must be a rook or queen
-      for (int i = pieceColumn + 1; i < Board::NUM_COLUMNS; ++i)
+      // if we're on the starting rank, then we can move ahead 2
+      int to2 = to + forward;
+      if ((kind & MOVES_quiet)
+          && (BitboardUtil::getRow(from) == startRow)
+          && !(occupied & BitboardUtil::getMask(to2))
+          && (allowed & BitboardUtil::getMask(to2)))
       {
-        Piece::Type otherPieceType = board.getPiece(i, pieceRow).getType();
-        if (otherPieceType != Piece::PIECE_none)
-        {
-          return (otherPieceType & mask);
-        }
+        moveList.push_back(PackedMove(from, to2, 
+                                      PackedMove::FLAG_doublePush));
       }
-      
-      // we must not have found an attacker lurking, so this move won't 
-      // put is in check
-      return false;
-    }
-  }
-  // DIAGONAL 1 (/)
-  ////////////////////////////////////////////////////////////////////////
-  else if ((kingColumn - kingRow) == (pieceColumn - pieceRow))
-  {
-    // if the piece is not moving off this diagonal, then it's not putting
-    // the king in check
-    if ((pieceColumn - pieceRow) == (move.getEndColumn() - move.getEndRow()))
-    {
-      return false;
     }
 
-    // this is a mask for diagonal attackers of the opposite color
-    int mask = 0;
-    if (myKing.getType() == Piece::PIECE_whiteKing)
-    {
-      mask = (static_cast<int>(Piece::PIECE_blackBishop)
-              | static_cast<int>(Piece::PIECE_blackQueen));
-    }
-    else
+    if (!(kind & MOVES_tactical))
     {
-      mask = (static_cast<int>(Piece::PIECE_whiteBishop)
-              | static_cast<int>(Piece::PIECE_whiteQueen));
+      continue;
     }
 
-    if (kingRow > pieceRow)
+    // captures
+    Bitboard captures = (Attacks::getPawnAttacks(us, from) 
+                         & opponentPieces & allowed);
+    while (captures)
     {
-      // in order to induce check, there can't be anything between my piece
-      // and the king      
-      for (int i = pieceColumn + 1, j = pieceRow + 1;
-           i < kingColumn; // don't need to check j 
-           ++i, ++j)
+      to = BitboardUtil::popFirstSquare(captures);
+      if (BitboardUtil::getRow(to) == promotionRow)
       {
-        if (board.getPiece(i, j).getType() != Piece::PIECE_none)
-        {
-          return false;
-        }
+        addPromotions(moveList, from, to, true);
       }
-
-      // then, on the other side of my piece, there must be a rook or queen
-      for (int i = pieceColumn - 1, j = pieceRow - 1;
-           i >= 0; // don't need to check j
-           --i, --j)
+      else
       {
-        Piece::Type otherPieceType = board.getPiece(i, j).getType();
-        if (otherPieceType != Piece::PIECE_none)
-        {
-          return (otherPieceType & mask);
-        }
+        moveList.push_back(PackedMove(from, to, PackedMove::FLAG_capture));
       }
-      
-      // we must not have found an attacker lurking, so this move won't 
-      // put is in check
-      return false;
     }
-    else
+
+    // en passant. this removes two pieces from the same row at once, so
+    // the pin test above isn't enough: check the king directly
+    if ((epSquare >= 0)
+        && (Attacks::getPawnAttacks(us, from) 
+            & BitboardUtil::getMask(epSquare)))
     {
-      // in order to induce check, there can't be anything between my piece
-      // and the king      
-      for (int i = kingColumn + 1, j = kingRow + 1;
-           i < pieceColumn; // don't need to check j 
-           ++i, ++j)
+      // in check, the capture must take the checker or block the check
+      if (checkers 
+          && !(checkers & BitboardUtil::getMask(epCapture))
+          && !(targets & BitboardUtil::getMask(epSquare)))
       {
-        if (board.getPiece(i, j).getType() != Piece::PIECE_none)
-        {
-          return false;
-        }
+        continue;
       }
 
-      // then, on the other side of my piece, there must be a rook or queen
-      for (int i = pieceColumn + 1, j = pieceRow + 1;
-           i < board::NUM_COLUMNS; // don't need to check j
-           ++i, ++j)
+      if (kingSquare >= 0)
       {
-        Piece::Type otherPieceType = board.getPiece(i, j).getType();
-        if (otherPieceType != Piece::PIECE_none)
+        Bitboard after = ((occupied
+                           ^ BitboardUtil::getMask(from)
+                           ^ BitboardUtil::getMask(epCapture))
+                          | BitboardUtil::getMask(epSquare));
+        Bitboard queens = board.getPieces(getType(them, OFFSET_queen));
+
+        if ((Attacks::getRookAttacks(kingSquare, after)
+             & (board.getPieces(getType(them, OFFSET_rook)) | queens))
+            || (Attacks::getBishopAttacks(kingSquare, after)
+                & (board.getPieces(getType(them, OFFSET_bishop)) | queens)))
         {
-          return (otherPieceType & mask);
+          continue;
         }
       }
-      
-      // we must not have found an attacker lurking, so this move won't 
-      // put is in check
-      return false;
+
+      moveList.push_back(PackedMove(from, epSquare, 
+                                    PackedMove::FLAG_enPassant));
     }
   }
-  // DIAGONAL (\)
-  ////////////////////////////////////////////////////////////////////////
-  else if ((kingColumn + kingRow) == (pieceColumn + pieceRow))
+}
+
+void BoardUtil::populateCastle(const Board& board, 
+                               Bitboard attacked,
+                               MoveBuffer<>& moveList)
+{
+  // add castling moves: The king cannot be in check currently and cannot
+  // be in check during any part of the castling maneuver. The caller has
+  // already established that the king is not in check.
+  const Board::Color color = board.getTurn();
+  const int us = Board::getColorIndex(color);
+  const int row = (us ? (Board::NUM_ROWS - 1) : 0);
+  const Bitboard occupied = board.getOccupied();
+  const Bitboard rooks = board.getPieces(getType(us, OFFSET_rook));
+  const int kingSquare = BitboardUtil::getSquare(4, row);
+
+  bool queenCastle = (us 
+                      ? board.getBlackQueenCastle()
+                      : board.getWhiteQueenCastle());
+  bool kingCastle = (us
+                     ? board.getBlackKingCastle()
+                     : board.getWhiteKingCastle());
+
+  if (queenCastle
+      && (rooks & BitboardUtil::getMask(BitboardUtil::getSquare(0, row)))
+      && !(occupied & Attacks::getBetween(kingSquare,
+                                          BitboardUtil::getSquare(0, row)))
+      && !(attacked & BitboardUtil::getMask(kingSquare - 1))
+      && !(attacked & BitboardUtil::getMask(kingSquare - 2)))
+  {
+    moveList.push_back(PackedMove(kingSquare, kingSquare - 2,
+                                  PackedMove::FLAG_queenCastle));
+  }
+
+  if (kingCastle
+      && (rooks & BitboardUtil::getMask(BitboardUtil::getSquare(7, row)))
+      && !(occupied & Attacks::getBetween(kingSquare,
+                                          BitboardUtil::getSquare(7, row)))
+      && !(attacked & BitboardUtil::getMask(kingSquare + 1))
+      && !(attacked & BitboardUtil::getMask(kingSquare + 2)))
+  {
+    moveList.push_back(PackedMove(kingSquare, kingSquare + 2,
+                                  PackedMove::FLAG_kingCastle));
+  }
+}
+
+bool BoardUtil::isSquareAttacked(const Board& board, 
+                                 int square, 
+                                 Board::Color color)
+{
+  return isSquareAttacked(board, square, color, board.getOccupied());
+}
+
+bool BoardUtil::isSquareAttacked(const Board& board, 
+                                 int square, 
+                                 Board::Color color,
+                                 Bitboard occupied)
+{
+  Bitboard bishops;
+  Bitboard rooks;
+
+  if (color == Board::COLOR_white)
   {
-    // if the piece is not moving off this diagonal, then it's not putting
-    // the king in check
-    if ((pieceColumn + pieceRow) == (move.getEndColumn() + move.getEndRow()))
+    // a white pawn attacks the square if a black pawn on the square would
+    // attack the white pawn
+    if (Attacks::getPawnAttacks(1, square)
+        & board.getPieces(Piece::PIECE_whitePawn))
     {
-      return false;
+      return true;
     }
 
-    // this is a mask for diagonal attackers of the opposite color
-    int mask = 0;
-    if (myKing.getType() == Piece::PIECE_whiteKing)
+    if ((Attacks::getKnightAttacks(square)
+         & board.getPieces(Piece::PIECE_whiteKnight))
+        || (Attacks::getKingAttacks(square)
+            & board.getPieces(Piece::PIECE_whiteKing)))
     {
-      mask = (static_cast<int>(Piece::PIECE_blackBishop)
-              | static_cast<int>(Piece::PIECE_blackQueen));
+      return true;
     }
-    else
+
+    bishops = (board.getPieces(Piece::PIECE_whiteBishop)
+               | board.getPieces(Piece::PIECE_whiteQueen));
+    rooks = (board.getPieces(Piece::PIECE_whiteRook)
+             | board.getPieces(Piece::PIECE_whiteQueen));
+  }
+  else
+  {
+    if (Attacks::getPawnAttacks(0, square)
+        & board.getPieces(Piece::PIECE_blackPawn))
     {
-      mask = (static_cast<int>(Piece::PIECE_whiteBishop)
-              | static_cast<int>(Piece::PIECE_whiteQueen));
+      return true;
     }
 
-    // King is to NorthWest of piece
-    if (kingRow > pieceRow)
+    if ((Attacks::getKnightAttacks(square)
+         & board.getPieces(Piece::PIECE_blackKnight))
+        || (Attacks::getKingAttacks(square)
+            & board.getPieces(Piece::PIECE_blackKing)))
     {
-      // in order to induce check, there can't be anything between my piece
-      // and the king      
-      for (int i = pieceColumn - 1, j = pieceRow + 1;
-           i > kingColumn; // don't need to check j 
-           --i, ++j)
-      {
-        if (board.getPiece(i, j).getType() != Piece::PIECE_none)
-        {
-          return false;
-        }
-      }
-
-      // then, on the other side of my piece, there must be a rook or queen
-      for (int i = pieceColumn + 1, j = pieceRow - 1;
-           j >= 0; // don't need to check i
-           ++i, --j)
-      {
-        Piece::Type otherPieceType = board.getPiece(i, j).getType();
-        if (otherPieceType != Piece::PIECE_none)
-        {
-          return (otherPieceType & mask);
-        }
-      }
-      
-      // we must not have found an attacker lurking, so this move won't 
-      // put is in check
-      return false;
+      return true;
     }
-    else
-    {
-      // in order to induce check, there can't be anything between my piece
-      // and the king      
-      for (int i = kingColumn - 1, j = kingRow + 1;
-           j < pieceRow; // don't need to check i
-           --i, ++j)
-      {
-        if (board.getPiece(i, j).getType() != Piece::PIECE_none)
-        {
-          return false;
-        }
-      }
 
-      // then, on the other side of my piece, there must be a rook or queen
-      for (int i = pieceColumn - 1, j = pieceRow + 1;
-           i >= 0; // don't need to check j
-           --i, ++j)
-      {
-        Piece::Type otherPieceType = board.getPiece(i, j).getType();
-        if (otherPieceType != Piece::PIECE_none)
-        {
-          return (otherPieceType & mask);
-        }
-      }
-      
-      // we must not have found an attacker lurking, so this move won't 
-      // put is in check
-      return false;
-    }
+    bishops = (board.getPieces(Piece::PIECE_blackBishop)
+               | board.getPieces(Piece::PIECE_blackQueen));
+    rooks = (board.getPieces(Piece::PIECE_blackRook)
+             | board.getPieces(Piece::PIECE_blackQueen));
   }
 
-  return false;
+  return ((Attacks::getBishopAttacks(square, occupied) & bishops)
+          || (Attacks::getRookAttacks(square, occupied) & rooks));
 }
-#endif
+
 
 bool BoardUtil::inCheck(const Board& board, Board::Color color)
 {
+  Bitboard king = board.getPieces((color == Board::COLOR_white)
+                                  ? Piece::PIECE_whiteKing
+                                  : Piece::PIECE_blackKing);
+  if (!king)
+  {
+    return false;
+  }
 
-  // find color's king
-  int col = -1;
-  int row = -1;
   Board::Color oppositeColor = ((color == Board::COLOR_white)
                                 ? Board::COLOR_black
                                 : Board::COLOR_white);
-  Piece::Type colorKing = ((color == Board::COLOR_white)
-                           ? Piece::PIECE_whiteKing
-                           : Piece::PIECE_blackKing);
-  PieceList pieceList = board.getPieceList();
-  for (PieceList::const_iterator iter = pieceList.begin();
-       iter != pieceList.end();
-       ++iter)
+
+  return isSquareAttacked(board, BitboardUtil::getFirstSquare(king),
+                          oppositeColor);
+}
+
+int BoardUtil::getPieceValue(Piece::Type type)
+{
+  return ((type == Piece::PIECE_none)
+          ? 0
+          : PIECE_VALUES[Piece::getIndex(type) % 6]);
+}
+
+int BoardUtil::getExchangeValue(const Board& board, PackedMove move)
+{
+  const int from = move.getFrom();
+  const int to = move.getTo();
+  Board::Color side = board.getTurn();
+
+  // gains[i] is what the side making capture i wins if the other side
+  // stops there
+  int gains[MAX_EXCHANGE + 1];
+  int onSquare = getPieceValue(board.getPieceType(from));
+  Bitboard occupied = board.getOccupied() & ~BitboardUtil::getMask(from);
+
+  if (move.isEnPassant())
+  {
+    gains[0] = PIECE_VALUES[OFFSET_pawn];
+    occupied &= ~BitboardUtil::getMask(
+      BitboardUtil::getSquare(BitboardUtil::getColumn(to),
+                              BitboardUtil::getRow(from)));
+  }
+  else
+  {
+    gains[0] = getPieceValue(board.getPieceType(to));
+  }
+
+  if (move.isPromotion())
   {
-    if (iter->getType() == colorKing)
+    onSquare = getPieceValue(
+      move.getPromotionType(Board::getColorIndex(side)));
+    gains[0] += onSquare - PIECE_VALUES[OFFSET_pawn];
+  }
+
+  // sliders behind a piece that has left join in, since the attackers are
+  // worked out again against the pieces still on the board
+  int depth = 0;
+  while (depth < MAX_EXCHANGE)
+  {
+    side = ((side == Board::COLOR_white)
+            ? Board::COLOR_black
+            : Board::COLOR_white);
+    Bitboard attackers = (getAttackers(board, to, occupied)
+                          & occupied
+                          & board.getOccupied(side));
+    if (!attackers)
     {
-      col = iter->getColumn();
-      row = iter->getRow();
+      break;
+    }
+
+    // the least valuable attacker takes
+    const int colorIndex = Board::getColorIndex(side);
+    int offset = OFFSET_pawn;
+    Bitboard attacker = 0;
+    for (; offset >= OFFSET_king; --offset)
+    {
+      attacker = (attackers
+                  & board.getPieces(getType(colorIndex, PieceOffset(offset))));
+      if (attacker)
+      {
+        break;
+      }
     }
-  }
 
-  // get all available moves for the opposite color
-  MoveList moveList;
-  populateAttackList(board, oppositeColor, moveList);
+    ++depth;
+    gains[depth] = onSquare - gains[depth - 1];
+    onSquare = PIECE_VALUES[offset];
+    occupied &= ~BitboardUtil::getMask(BitboardUtil::getFirstSquare(attacker));
+  }
 
-  // look to see if any of the opposite color's move attack [col, row]
-  for (MoveList::const_iterator iter = moveList.begin();
-       iter != moveList.end();
-       ++iter)
+  // each side only makes its capture if it comes out ahead of stopping
+  while (depth > 0)
   {
-    if ((iter->getEndColumn() == col)
-        && (iter->getEndRow() == row))
+    if (gains[depth] > -gains[depth - 1])
     {
-      return true;
+      gains[depth - 1] = -gains[depth];
     }
+    --depth;
   }
 
-  return false;
+  return gains[0];
+}
+
+Bitboard BoardUtil::getAttackMap(const Board& board, Board::Color color)
+{
+  return getAttackMap(board, color, board.getOccupied());
+}
+
+Bitboard BoardUtil::getAttackMap(const Board& board, 
+                                 Board::Color color,
+                                 Bitboard occupied)
+{
+  const int us = Board::getColorIndex(color);
+  const Bitboard pawns = board.getPieces(getType(us, OFFSET_pawn));
+  const Bitboard queens = board.getPieces(getType(us, OFFSET_queen));
+  Bitboard attacks;
+
+  // all pawn attacks at once: shift the pawns diagonally forward, dropping
+  // any that wrap around the side of the board
+  if (us == 0)
+  {
+    attacks = (((pawns << 7) & ~COLUMN_H) | ((pawns << 9) & ~COLUMN_A));
+  }
+  else
+  {
+    attacks = (((pawns >> 9) & ~COLUMN_H) | ((pawns >> 7) & ~COLUMN_A));
+  }
+
+  Bitboard pieces = board.getPieces(getType(us, OFFSET_knight));
+  while (pieces)
+  {
+    attacks |= Attacks::getKnightAttacks(BitboardUtil::popFirstSquare(pieces));
+  }
+
+  pieces = (board.getPieces(getType(us, OFFSET_bishop)) | queens);
+  while (pieces)
+  {
+    attacks |= Attacks::getBishopAttacks(BitboardUtil::popFirstSquare(pieces),
+                                         occupied);
+  }
+
+  pieces = (board.getPieces(getType(us, OFFSET_rook)) | queens);
+  while (pieces)
+  {
+    attacks |= Attacks::getRookAttacks(BitboardUtil::popFirstSquare(pieces),
+                                       occupied);
+  }
+
+  pieces = board.getPieces(getType(us, OFFSET_king));
+  while (pieces)
+  {
+    attacks |= Attacks::getKingAttacks(BitboardUtil::popFirstSquare(pieces));
+  }
+
+  return attacks;
+}
+
+void BoardUtil::convertMoveList(const Board& board,
+                                const MoveBuffer<>& buffer,
+                                MoveList& moveList)
+{
+  moveList.clear();
+  moveList.reserve(buffer.size());
+
+  for (MoveBuffer<>::const_iterator iter = buffer.begin();
+       iter != buffer.end();
+       ++iter)
+  {
+    moveList.push_back(iter->toMove(board.getPieceType(iter->getFrom())));
+  }
 }
 
 State BoardUtil::calculateState(const Board& board)
 {
-  MoveList moveList;
+  // most positions have a legal move, and the search for one stops as soon
+  // as it is found
+  if (!hasLegalMove(board))
+  {
+    if (inCheck(board, board.getTurn()))
+    {
+      return ((board.getTurn() == Board::COLOR_white)
+              ? STATE_blackWon
+              : STATE_whiteWon);
+    }
+
+    return STATE_draw;
+  }
 
-  // get all available moves for color that's supposed to be moving
-  populateMoveList(board, moveList);
+  // if neither side has mating material, then the situation is drawn
+  return (Material::isDeadDraw(board.getMaterialKey())
+          ? STATE_draw
+          : STATE_ongoing);
+}
 
+State BoardUtil::calculateState(const Board& board,
+                                const MoveBuffer<>& moveList,
+                                bool check)
+{
   // if the color cannot move, then something is up!
   if (!moveList.size())
   {
     // if the color is in check, then this is checkmate
-    if (inCheck(board, board.getTurn()))
+    if (check)
     {
       if (board.getTurn() == Board::COLOR_white)
       {
@@ -1187,8 +985,8 @@ State BoardUtil::calculateState(const Board& board)
   // else there are moves left
   else
   {
-    // if there are only kings left, then the situation is drawn
-    if (board.getPieceList().size() == 2)
+    // if neither side has mating material, then the situation is drawn
+    if (Material::isDeadDraw(board.getMaterialKey()))
     {
       return STATE_draw;
     }
@@ -1241,5 +1039,202 @@ void BoardUtil::initializeBoard(Board& board)
   board.addPiece(Piece(7, 7, Piece::PIECE_blackRook));  
 }
 
-} // namespace sage
+void BoardUtil::setFen(Board& board, const std::string& fen)
+{
+  std::istringstream in(fen);
+  std::string placement;
+  std::string turn;
+  std::string castles;
+  std::string enPassant;
+
+  if (!(in >> placement >> turn >> castles >> enPassant))
+  {
+    throw Exception("FEN is missing fields");
+  }
+
+  Board result;
+  int col = 0;
+  int row = Board::NUM_ROWS - 1;
+
+  for (std::string::const_iterator iter = placement.begin();
+       iter != placement.end();
+       ++iter)
+  {
+    if (*iter == '/')
+    {
+      if ((col != Board::NUM_COLUMNS) || (row == 0))
+      {
+        throw Exception("FEN has a malformed row");
+      }
+      col = 0;
+      --row;
+    }
+    else if ((*iter >= '1') && (*iter <= '8'))
+    {
+      col += (*iter - '0');
+    }
+    else
+    {
+      const char* letter = std::strchr(FEN_PIECES, *iter);
+      if ((*iter == '\0') || (letter == 0) || (col >= Board::NUM_COLUMNS))
+      {
+        throw Exception("FEN has an invalid piece placement");
+      }
+
+      result.addPiece(Piece(col, row, 
+                            Piece::getTypeFromIndex(letter - FEN_PIECES)));
+      ++col;
+    }
+
+    if (col > Board::NUM_COLUMNS)
+    {
+      throw Exception("FEN has a malformed row");
+    }
+  }
+
+  if ((row != 0) || (col != Board::NUM_COLUMNS))
+  {
+    throw Exception("FEN does not describe eight rows");
+  }
+
+  // the move generator relies on both of these
+  if (!validateBoard(result))
+  {
+    throw Exception("FEN has pawns on an end rank or not one king a side");
+  }
+
+  if ((turn != "w") && (turn != "b"))
+  {
+    throw Exception("FEN has an invalid side to move");
+  }
+  result.setTurn((turn == "w") ? Board::COLOR_white : Board::COLOR_black);
+
+  result.setWhiteKingCastle(castles.find('K') != std::string::npos);
+  result.setWhiteQueenCastle(castles.find('Q') != std::string::npos);
+  result.setBlackKingCastle(castles.find('k') != std::string::npos);
+  result.setBlackQueenCastle(castles.find('q') != std::string::npos);
+
+  if (enPassant == "-")
+  {
+    result.setEnPassantColumn(-1);
+  }
+  else if ((enPassant.size() == 2) 
+           && (enPassant[0] >= 'a') && (enPassant[0] <= 'h'))
+  {
+    // like Board::makeMove, only keep the square if a pawn can capture
+    const int us = Board::getColorIndex(result.getTurn());
+    int square = BitboardUtil::getSquare(enPassant[0] - 'a', us ? 2 : 5);
+    bool usable = ((Attacks::getPawnAttacks(1 - us, square)
+                    & result.getPieces(getType(us, OFFSET_pawn))) != 0);
+    result.setEnPassantColumn(usable ? (enPassant[0] - 'a') : -1);
+  }
+  else
+  {
+    throw Exception("FEN has an invalid en passant square");
+  }
+
+  // the halfmove clock is optional
+  int halfmoveClock = 0;
+  if ((in >> halfmoveClock) && (halfmoveClock >= 0))
+  {
+    result.setHalfmoveClock(halfmoveClock);
+  }
+
+  board = result;
+}
+
+bool BoardUtil::validateBoard(const Board& board)
+{
+  const Bitboard END_ROWS = 0xff000000000000ffULL;
+  if ((board.getPieces(Piece::PIECE_whitePawn)
+       | board.getPieces(Piece::PIECE_blackPawn)) & END_ROWS)
+  {
+    return false;
+  }
+
+  return ((BitboardUtil::popCount(board.getPieces(Piece::PIECE_whiteKing))
+           == 1)
+          && (BitboardUtil::popCount(board.getPieces(Piece::PIECE_blackKing))
+              == 1));
+}
+
+std::string BoardUtil::getFen(const Board& board)
+{
+  std::string fen;
+
+  for (int row = Board::NUM_ROWS - 1; row >= 0; --row)
+  {
+    int empty = 0;
+    for (int col = 0; col < Board::NUM_COLUMNS; ++col)
+    {
+      Piece::Type type = board.getPieceType(BitboardUtil::getSquare(col, 
+                                                                    row));
+      if (type == Piece::PIECE_none)
+      {
+        ++empty;
+        continue;
+      }
+
+      if (empty)
+      {
+        fen += static_cast<char>('0' + empty);
+        empty = 0;
+      }
+      fen += FEN_PIECES[Piece::getIndex(type)];
+    }
+
+    if (empty)
+    {
+      fen += static_cast<char>('0' + empty);
+    }
+
+    if (row)
+    {
+      fen += '/';
+    }
+  }
+
+  fen += ((board.getTurn() == Board::COLOR_white) ? " w " : " b ");
+
+  std::string castles;
+  for (int i = 0; i < 4; ++i)
+  {
+    if (board.getStateWord() & CASTLE_FLAGS[i])
+    {
+      castles += FEN_CASTLES[i];
+    }
+  }
+  fen += (castles.empty() ? std::string("-") : castles);
 
+  if (board.getEnPassantColumn() < 0)
+  {
+    fen += " -";
+  }
+  else
+  {
+    fen += ' ';
+    fen += static_cast<char>('a' + board.getEnPassantColumn());
+    fen += ((board.getTurn() == Board::COLOR_white) ? '6' : '3');
+  }
+
+  return fen;
+}
+
+std::string BoardUtil::getMoveString(PackedMove move)
+{
+  std::string text;
+  text += static_cast<char>('a' + BitboardUtil::getColumn(move.getFrom()));
+  text += static_cast<char>('1' + BitboardUtil::getRow(move.getFrom()));
+  text += static_cast<char>('a' + BitboardUtil::getColumn(move.getTo()));
+  text += static_cast<char>('1' + BitboardUtil::getRow(move.getTo()));
+
+  if (move.isPromotion())
+  {
+    // the low two flag bits count knight, bishop, rook, queen
+    text += "nbrq"[move.getFlags() & 3];
+  }
+
+  return text;
+}
+
+} // namespace sage
@@ -9,10 +9,23 @@
 #include "sage/Move.h"
 #endif
 
+#ifndef INCLUDED_sage_PackedMove_h
+#include "sage/PackedMove.h"
+#endif
+
+#ifndef INCLUDED_sage_MoveBuffer_h
+#include "sage/MoveBuffer.h"
+#endif
+
 #ifndef INCLUDED_sage_State_h
 #include "sage/State.h"
 #endif
 
+#ifndef INCLUDED_std_string
+#include <string>
+#define INCLUDED_std_string
+#endif
+
 namespace sage {
 
 /*!
@@ -26,7 +39,13 @@ class BoardUtil
 {
  public:
 
-  typedef int AttackMatrix[Board::NUM_COLUMNS][Board::NUM_ROWS];
+  //! Kinds of move, for generating them in stages
+  enum MoveKind
+  {
+    MOVES_tactical = 1, //!< Captures (en passant included) and promotions
+    MOVES_quiet    = 2, //!< All other moves, castling included
+    MOVES_all      = 3  //!< Every move
+  };
 
   /*!
     \brief Default constructor
@@ -52,9 +71,107 @@ class BoardUtil
 
     This method clears the move list before adding anything to it. There is
     no guaranteed order for the moves placed into the move list.
+
+    Only legal moves are generated. The pieces pinned to the king and the
+    pieces giving check are worked out once up front; in check only
+    evasions are generated, and in double check only king moves.
   */
   static void populateMoveList(const Board& board, MoveList& moveList);
 
+  /*!
+    \brief Populates the given packed move list with all valid moves for
+    the given board position.
+    \param board The board for which we are calculating the move list
+    \moveList [out] The move list to populate
+
+    This is the same as the MoveList version, but each move takes 2 bytes
+    instead of a full Move object.
+  */
+  static void populateMoveList(const Board& board, 
+                               PackedMoveList& moveList);
+
+  /*!
+    \brief Populates the given move buffer with all valid moves for the
+    given board position.
+    \param board The board for which we are calculating the move list
+    \moveList [out] The move buffer to populate
+
+    This is the generator that the other populateMoveList versions are
+    built on. It does no heap allocation, so it is the one to use in
+    search and other hot paths.
+  */
+  static void populateMoveList(const Board& board,
+                               MoveBuffer<>& moveList);
+
+  /*!
+    \brief Populates the given move buffer and reports whether the side to
+    move is in check
+    \param board The board for which we are calculating the move list
+    \moveList [out] The move buffer to populate
+    \check [out] Whether the side to move is in check
+
+    The generator works out the checking pieces anyway, so this is cheaper
+    than calling inCheck() separately.
+  */
+  static void populateMoveList(const Board& board,
+                               MoveBuffer<>& moveList,
+                               bool& check);
+
+  /*!
+    \brief Populates the given move buffer with the legal moves of one
+    kind
+    \param board The board for which we are calculating the move list
+    \param kind The kind of moves to generate
+    \param moveList [out] The move buffer to populate
+
+    Generating the tactical and quiet moves separately gives the same
+    moves as generating them all at once. A search can try the tactical
+    moves first and skip generating the quiet ones if it cuts off.
+  */
+  static void populateMoveList(const Board& board,
+                               MoveKind kind,
+                               MoveBuffer<>& moveList);
+
+  /*!
+    \brief Returns whether a move is legal for the side to move
+    \param board The board
+    \param move The move, which may be any 16 bits (e.g. from a hash table)
+
+    Only the moves of the piece on the start square are generated.
+  */
+  static bool isLegalMove(const Board& board, PackedMove move);
+
+  /*!
+    \brief Returns whether the side to move has any legal move
+    \param board The board
+
+    This stops at the first legal move it finds, trying the king and the
+    other pieces (whose moves can be tested as bitboards) before the
+    pawns. It is much cheaper than generating every move when all that
+    matters is whether the game is over.
+  */
+  static bool hasLegalMove(const Board& board);
+
+  /*!
+    \brief Returns the number of legal moves for the side to move
+    \param board The board
+
+    Moves of the king and the other pieces are counted with a population
+    count of their target squares instead of being listed. This is what
+    perft uses at its last ply.
+  */
+  static int countLegalMoves(const Board& board);
+
+  /*!
+    \brief Converts a move buffer into a list of full Move objects
+    \param board The board the moves are for
+    \param buffer The moves
+    \moveList [out] The move list to populate; it is cleared first
+  */
+  static void convertMoveList(const Board& board,
+                              const MoveBuffer<>& buffer,
+                              MoveList& moveList);
+
   /*!
     \brief Populates the given move list with all valid attacks for the given
     board position.
@@ -73,26 +190,160 @@ class BoardUtil
                                  const Board::Color color, 
                                  MoveList& moveList);
 
+  /*!
+    \brief Determines if any piece of the given color attacks a square
+    \param board The current board
+    \param square The square index to test
+    \param color The color of the attacking pieces
+    \retval true If the square is attacked
+    \retval false If the square is not attacked
+  */
+  static bool isSquareAttacked(const Board& board, 
+                               int square, 
+                               Board::Color color);
+
+  /*!
+    \brief Determines if any piece of the given color attacks a square
+    \param board The current board
+    \param square The square index to test
+    \param color The color of the attacking pieces
+    \param occupied The pieces to treat as blockers for sliding attacks.
+    This lets callers ask what would be attacked with pieces removed.
+    \retval true If the square is attacked
+    \retval false If the square is not attacked
+  */
+  static bool isSquareAttacked(const Board& board, 
+                               int square, 
+                               Board::Color color,
+                               Bitboard occupied);
+
+  /*!
+    \brief Returns all pieces of either color that attack a square
+    \param board The current board
+    \param square The square index
+    \param occupied The pieces to treat as blockers for sliding attacks
+    \return The squares of the attacking pieces
+  */
+  static Bitboard getAttackers(const Board& board, 
+                               int square, 
+                               Bitboard occupied);
+
+  /*!
+    \brief Returns every square attacked by the given color
+    \param board The current board
+    \param color The color of the attacking pieces
+    \return The attacked squares
+
+    The map is built with one table lookup per piece (pawns are handled
+    all at once), so testing any number of squares against it afterwards
+    is a single AND each.
+  */
+  static Bitboard getAttackMap(const Board& board, Board::Color color);
+
+  /*!
+    \brief Returns every square attacked by the given color
+    \param board The current board
+    \param color The color of the attacking pieces
+    \param occupied The pieces to treat as blockers for sliding attacks
+    \return The attacked squares
+  */
+  static Bitboard getAttackMap(const Board& board, 
+                               Board::Color color,
+                               Bitboard occupied);
+
   /*!
     \brief Determines if the given color is in check on the specified board
     \param board The current board
     \param color The color to check for being in check
+
+    This only looks at the attackers of the king's square.
   */
   static bool inCheck(const Board& board, Board::Color color);
 
+  /*!
+    \brief Returns the value of a piece for exchanges, in centipawns
+    \param type The piece; PIECE_none is worth nothing
+
+    These are the plain textbook values (pawn 100, knight and bishop 300,
+    rook 500, queen 900). The king is worth more than everything else
+    together, so an exchange never gives it up.
+  */
+  static int getPieceValue(Piece::Type type);
+
+  /*!
+    \brief Works out the material a move wins once all the captures on its
+    end square have been played out (static exchange evaluation)
+    \param board The board, with the move not yet made
+    \param move A legal move for the board
+    \return The gain for the side making the move, in centipawns;
+    negative if the move loses material
+
+    After the move, the two sides take turns recapturing on the end square,
+    each with its least valuable piece, and each may stop whenever going on
+    would lose. Pieces that are uncovered as others leave (e.g. a rook
+    behind a rook) join in. Pins and checks are ignored, as is a pawn
+    promoting as it recaptures. A promotion counts the gain of the new
+    piece over the pawn.
+  */
+  static int getExchangeValue(const Board& board, PackedMove move);
+
   /*!
     \brief Calculates the state of the given board
     \param board The board
     \return The board state
+
+    Besides checkmate and stalemate, the game is drawn when neither side
+    has the material to mate (see Material::isDeadDraw()).
   */
   static State calculateState(const Board& board);
 
+  /*!
+    \brief Calculates the state of the given board from its legal moves
+    \param board The board
+    \param moveList All legal moves for the board
+    \param check Whether the side to move is in check
+    \return The board state
+
+    Use this when the moves have already been generated, e.g. by the
+    populateMoveList() version that also reports check.
+  */
+  static State calculateState(const Board& board,
+                              const MoveBuffer<>& moveList,
+                              bool check);
+
   /*!
     \brief Initializes given board to default chess starting position.
     \param board [inout] The board
   */
   static void initializeBoard(Board& board);
 
+  /*!
+    \brief Sets up the given board from a FEN string
+    \param board [out] The board
+    \param fen The position in Forsyth-Edwards Notation
+
+    The first four fields (placement, side to move, castling and en
+    passant) are required. The halfmove clock is read if present and the
+    fullmove number is ignored. As with Board::makeMove(), an en passant
+    square is dropped if no pawn can capture onto it. Throws Exception if
+    the string cannot be parsed or the position fails validateBoard(), in
+    which case the board is left unchanged.
+  */
+  static void setFen(Board& board, const std::string& fen);
+
+  /*!
+    \brief Returns the FEN string for the given board
+    \param board The board
+    \return The first four FEN fields describing the position
+  */
+  static std::string getFen(const Board& board);
+
+  /*!
+    \brief Returns a move in coordinate notation, e.g. "e2e4" or "a7a8q"
+    \param move The move
+  */
+  static std::string getMoveString(PackedMove move);
+
   /*!
     \brief Validates the specified board
     \param Board the board to validate
@@ -102,113 +353,123 @@ class BoardUtil
     This method will check to see if the specified board position is valid
     for chess play. The following items are verified:
     - Pawns cannot be in the first and eighth ranks
-    - There can only be one king per side
+    - There must be exactly one king per side
   */
   static bool validateBoard(const Board& board);
 
  private:
-  /*!
-    \brief Fills moveList with all possible king moves
-    \param piece The king we're moving
-    \param board The board we're moving on
-    \param moveList [out] The move list we're populating
-  */
-  static void populateKingAttacks(const Piece& piece,
-                                  const Board& board, 
-                                  MoveList& moveList);
+
+  //! What the legal move generator works out about a position up front
+  struct MoveContext
+  {
+    int m_kingSquare;       //!< King of the side to move; -1 if none
+    Bitboard m_attacked;    //!< Squares the opponent attacks, sans king
+    Bitboard m_checkers;    //!< Opponent pieces giving check
+    Bitboard m_pinned;      //!< Own pieces pinned to the king
+    Bitboard m_targets;     //!< Squares non-king moves may land on
+    Bitboard m_kingTargets; //!< Squares the king may step to
+  };
 
   /*!
-    \brief Fills moveList with all possible rook moves
-    \param piece The rook we're moving
-    \param board The board we're moving on
-    \param moveList [out] The move list we're populating
+    \brief Works out the checks, pins and target squares for a position
+    \param board The board
+    \param context [out] The results
   */
-  static void populateRookAttacks(const Piece& piece,
-                                  const Board& board, 
-                                  MoveList& moveList);
+  static void getMoveContext(const Board& board, MoveContext& context);
 
   /*!
-    \brief Fills moveList with all possible bishop moves
-    \param piece The bishop we're moving
-    \param board The board we're moving on
-    \param moveList [out] The move list we're populating
+    \brief Adds legal moves to a move buffer
+    \param board The board
+    \param context The context from getMoveContext()
+    \param kind The kind of moves to add
+    \param from The squares whose pieces may move
+    \param moveList [out] The move buffer to add to
   */
-  static void populateBishopAttacks(const Piece& piece,
-                                    const Board& board, 
-                                    MoveList& moveList);
+  static void populateMoves(const Board& board,
+                            const MoveContext& context,
+                            MoveKind kind,
+                            Bitboard from,
+                            MoveBuffer<>& moveList);
 
   /*!
-    \brief Fills moveList with all possible knight moves
-    \param piece The knight we're moving
-    \param board The board we're moving on
-    \param moveList [out] The move list we're populating
+    \brief Returns the legal destination squares of a queen, rook, bishop
+    or knight of the side to move
+    \param board The board
+    \param context The context from getMoveContext()
+    \param offset Kind of piece, as an offset from the king's index
+    \param from The square the piece is on
   */
-  static void populateKnightAttacks(const Piece& piece,
-                                    const Board& board, 
-                                    MoveList& moveList);
+  static Bitboard getPieceTargets(const Board& board,
+                                  const MoveContext& context,
+                                  int offset,
+                                  int from);
 
   /*!
-    \brief Fills moveList with all possible WhitePawn moves
-    \param piece The WhitePawn we're moving
-    \param board The board we're moving on
+    \brief Adds a move from piece to each square in targets
+    \param piece The piece we're moving
+    \param targets The destination squares
     \param moveList [out] The move list we're populating
   */
-  static void populateWhitePawnMoves(const Piece& piece,
-                                     const Board& board, 
-                                     MoveList& moveList);
+  static void populateTargets(const Piece& piece,
+                              Bitboard targets,
+                              MoveList& moveList);
 
   /*!
-    \brief Fills moveList with all possible BlackPawn moves
-    \param piece The BlackPawn we're moving
-    \param board The board we're moving on
+    \brief Adds a move from a piece to each of the target squares
+    \param from The square the piece is on
+    \param targets The destination squares
+    \param opponentPieces The opponent's pieces, used to flag captures
     \param moveList [out] The move list we're populating
   */
-  static void populateBlackPawnMoves(const Piece& piece,
-                                     const Board& board, 
-                                     MoveList& moveList);
+  static void populateTargets(int from,
+                              Bitboard targets,
+                              Bitboard opponentPieces,
+                              MoveBuffer<>& moveList);
 
   /*!
-    \brief Fills moveList with all possible WhitePawn attacks
-    \param piece The WhitePawn we're moving
+    \brief Adds legal pawn moves for the side to move
     \param board The board we're moving on
+    \param pawns The pawns whose moves to add
+    \param kind The kind of moves to add
+    \param kingSquare The square of the king of the side to move
+    \param checkers The pieces giving check
+    \param pinned The pieces pinned to the king
+    \param targets The squares non-king moves must land on
     \param moveList [out] The move list we're populating
+
+    This includes pushes, captures, promotions and en passant.
   */
-  static void populateWhitePawnAttacks(const Piece& piece,
-                                       const Board& board, 
-                                       MoveList& moveList);
+  static void populatePawnMoves(const Board& board,
+                                Bitboard pawns,
+                                MoveKind kind,
+                                int kingSquare,
+                                Bitboard checkers,
+                                Bitboard pinned,
+                                Bitboard targets,
+                                MoveBuffer<>& moveList);
 
   /*!
-    \brief Fills moveList with all possible BlackPawn attacks
-    \param piece The BlackPawn we're moving
+    \brief Adds castling moves to a movelist
     \param board The board we're moving on
+    \param attacked The squares attacked by the opponent
     \param moveList [out] The move list we're populating
+
+    Must only be called when the side to move is not in check.
   */
-  static void populateBlackPawnAttacks(const Piece& piece,
-                                       const Board& board, 
-                                       MoveList& moveList);
+  static void populateCastle(const Board& board, 
+                             Bitboard attacked,
+                             MoveBuffer<>& moveList);
 
   /*!
-    \brief Adds castling moves to a movelist
-    \param board The board we're moving on
-    \param isAttacked array of whether a square is attacked
-    \param moveList [out] The move list we're populating
+    \brief Returns the pieces of the side to move that are pinned
+    \param board The board
+    \param kingSquare The square of the king of the side to move
+    \return The pinned pieces
+
+    A piece is pinned if it is the only piece between its own king and an
+    enemy rook, bishop or queen that would otherwise attack the king.
   */
-  static void populateCastle(
-    const Board& board, 
-    int isAttacked[Board::NUM_COLUMNS][Board::NUM_ROWS],
-    MoveList& moveList);
-
-  /*
-    \brief Determines if the specified move will put the moving color
-    into check.
-    \param move The move that we want to make
-    \param isAttacked Matrix of squares attacked by the opponent
-    \param board The board on which we're making the move
-    \param myKing The location of my king
-  */
-  static bool moveInducesCheck(const Move& move, 
-                               const Board& board, 
-                               const Piece& myKing);
+  static Bitboard getPinned(const Board& board, int kingSquare);
 };
 
 } // namespace sage
@@ -12,28 +12,16 @@
 #include "sage/Exception.h"
 #endif
 
-#ifndef INCLUDED_sage_BoardUtil_h
-#include "sage/BoardUtil.h"
-#endif
-
-#ifndef INCLUDED_std_iostream
-#include <iostream>
-#define INCLUDED_std_iostream
-#endif
-
 namespace sage {
 
 void Engine::run()
 { 
-
-  std::cout << "Engine::run()" << std::endl;
-  int turn = 1;
+  m_sink->record(GameEvent::makeStart(m_gameId));
 
   while (m_game.getState() == STATE_ongoing)
   {
-    // get list of legal moves
-    MoveList moveList;
-    BoardUtil::populateMoveList(m_game.getCurrentBoard(), moveList);
+    // the game already worked out the legal moves when it updated its state
+    const MoveList& moveList = m_game.getLegalMoves();
 
     int moveNum = 0;
 
@@ -53,12 +41,18 @@ void Engine::run()
       throw InvalidMoveException("Move number out of range");
     }
 
-    // apply the move
-    m_game.applyMove(moveList[moveNum]);
-    
-    std::cout << "Turn " << turn << " move: " << moveNum << std::endl;
-    turn++;
+    // apply the move; taken first since making it replaces the legal moves
+    PackedMove move = m_game.getLegalMove(moveNum);
+    int ply = static_cast<int>(m_game.getMoveList().size());
+    m_game.applyLegalMove(moveNum);
+    m_sink->record(GameEvent::makeMove(m_gameId, ply, move, moveNum));
+
+    m_adjudicator.update(m_game);
   }
+
+  m_sink->record(GameEvent::makeEnd(
+                   m_gameId, static_cast<int>(m_game.getMoveList().size()),
+                   m_game.getState(), m_game.getReason()));
 }
 
 
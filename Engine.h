@@ -1,10 +1,18 @@
 #ifndef INCLUDED_sage_Engine_h
 #define INCLUDED_sage_Engine_h
 
+#ifndef INCLUDED_sage_GameEvent_h
+#include "sage/GameEvent.h"
+#endif
+
 #ifndef INCLUDED_sage_Game_h
 #include "sage/Game.h"
 #endif
 
+#ifndef INCLUDED_sage_Adjudicator_h
+#include "sage/Adjudicator.h"
+#endif
+
 #ifndef INCLUDED_sage_Board_h
 #include "sage/Board.h"
 #endif
@@ -14,24 +22,36 @@ namespace sage {
 class Policy;
 
 /*!
-  \brief
+  \brief Plays a game between two policies
+
+  Besides the rules of chess, a game can be ended early by adjudication
+  (see Adjudicator). The rule that ended the game is available from
+  Game::getReason().
 */
 class Engine
 {
  public:
 
+  //! Settings for ending games early
+  typedef Adjudicator::Settings Adjudication;
+
   /*!
     \brief Constructor: Build game engine with given policies and start
     position
     \param white The policy to use for white
     \param black The policy to use for black
     \param board The starting position
+    \param adjudication Rules for ending the game early; none by default
 
     It is assumed that the board passed in here is fully constructed and
-    is valid (i.e. has the state set properly).
+    is valid (i.e. has the state set properly). The evaluator in
+    adjudication, if any, must outlive the engine.
   */
-  Engine(Policy& white, Policy& black, const Board& board)
-    : m_white(white), m_black(black), m_game(board)
+  Engine(Policy& white, Policy& black, const Board& board,
+         const Adjudication& adjudication = Adjudication())
+    : m_white(white), m_black(black), m_game(board),
+    m_adjudicator(adjudication), m_sink(&NullEventSink::getInstance()),
+    m_gameId(0)
   {
     ;
   }
@@ -59,13 +79,26 @@ class Engine
   */
   const Game& getGame() const { return m_game; }
 
+  /*!
+    \brief Sets where run() reports the game's events
+    \param sink The sink; it must outlive the engine. By default events
+    are discarded.
+    \param game Id of the game in the events
+  */
+  void setEventSink(GameEventSink& sink, uint32_t game = 0)
+  {
+    m_sink = &sink;
+    m_gameId = game;
+  }
+
   /*!
     \brief Runs the game
 
     When called, this method will alternately call Policy::decide() on
     the white and black policies to iterate through the entire game. Any
     user interaction should be set up through the derived policy classes.
-    This method will stop once the game has reached a terminal state.
+    This method will stop once the game has reached a terminal state or
+    has been adjudicated.
   */
   void run();
 
@@ -79,6 +112,15 @@ class Engine
 
   //! The ongoing chess game
   Game m_game;
+
+  //! Ends the game early
+  Adjudicator m_adjudicator;
+
+  //! Receives the game's events
+  GameEventSink* m_sink;
+
+  //! Id of the game in the events
+  uint32_t m_gameId;
 };
 
 } // namespace sage
@@ -0,0 +1,51 @@
+#include "sage/EvaluatorQueue.h"
+
+#ifndef INCLUDED_sage_BoardEvaluator_h
+#include "sage/BoardEvaluator.h"
+#endif
+
+namespace sage {
+
+EvaluatorQueue::EvaluatorQueue(BoardEvaluator& evaluator,
+                               GameScheduler& scheduler)
+  : m_evaluator(evaluator), m_scheduler(scheduler), m_pending(),
+    m_boards(), m_scores(), m_batches(0)
+{
+  m_scheduler.addIdleHandler([this] { return flush(); });
+}
+
+EvaluatorQueue::~EvaluatorQueue()
+{
+
+}
+
+bool EvaluatorQueue::flush()
+{
+  if (m_pending.empty())
+  {
+    return false;
+  }
+
+  // posting rather than resuming keeps m_pending stable until cleared
+  int count = static_cast<int>(m_pending.size());
+  m_boards.resize(count);
+  m_scores.resize(count);
+  for (int i = 0; i < count; ++i)
+  {
+    m_boards[i] = m_pending[i]->m_board;
+  }
+
+  m_evaluator.evaluateBatch(&m_boards[0], &m_scores[0], count);
+  ++m_batches;
+
+  for (int i = 0; i < count; ++i)
+  {
+    m_pending[i]->m_score = m_scores[i];
+    m_scheduler.post(m_pending[i]->m_handle);
+  }
+  m_pending.clear();
+
+  return true;
+}
+
+} // namespace sage
@@ -0,0 +1,120 @@
+#ifndef INCLUDED_sage_EvaluatorQueue_h
+#define INCLUDED_sage_EvaluatorQueue_h
+
+#ifndef INCLUDED_sage_GameScheduler_h
+#include "sage/GameScheduler.h"
+#endif
+
+#ifndef INCLUDED_std_coroutine
+#include <coroutine>
+#define INCLUDED_std_coroutine
+#endif
+
+#ifndef INCLUDED_std_vector
+#include <vector>
+#endif
+
+namespace sage {
+
+class Board;
+class BoardEvaluator;
+
+/*!
+  \brief Collects board evaluations from many games into batches
+
+  A coroutine policy co_awaits evaluate() and is suspended until the
+  queue is flushed. The queue registers flush() as an idle handler of the
+  GameScheduler, so it is flushed once every ready game has run as far as
+  it can: one call to BoardEvaluator::evaluateBatch() with many boards then
+  replaces many calls with one board each.
+*/
+class EvaluatorQueue
+{
+ public:
+
+  /*!
+    \brief Awaitable returned by evaluate(); produces the score
+  */
+  class Request
+  {
+   public:
+    Request(EvaluatorQueue& queue, const Board& board)
+      : m_queue(queue), m_board(&board), m_score(0.0), m_handle()
+    {
+      ;
+    }
+
+    bool await_ready() const noexcept { return false; }
+
+    void await_suspend(std::coroutine_handle<> handle)
+    {
+      m_handle = handle;
+      m_queue.m_pending.push_back(this);
+    }
+
+    double await_resume() const noexcept { return m_score; }
+
+   private:
+    friend class EvaluatorQueue;
+
+    EvaluatorQueue& m_queue;         //!< Queue the request waits in
+    const Board* m_board;            //!< The board to evaluate
+    double m_score;                  //!< Filled in by flush()
+    std::coroutine_handle<> m_handle; //!< Resumed once scored
+  };
+
+  /*!
+    \brief Constructor
+    \param evaluator Scores the boards; it must outlive the queue
+    \param scheduler Scheduler of the games using the queue; the queue
+    must outlive its run()
+  */
+  EvaluatorQueue(BoardEvaluator& evaluator, GameScheduler& scheduler);
+
+  /*!
+    \brief Destructor
+  */
+  virtual ~EvaluatorQueue();
+
+  /*!
+    \brief Returns an awaitable that scores a board
+    \param board The board; it must stay valid until the score arrives
+  */
+  Request evaluate(const Board& board) { return Request(*this, board); }
+
+  /*!
+    \brief Scores every waiting board and posts the waiting coroutines
+    \retval true If any boards were waiting
+    \retval false If the queue was empty
+  */
+  bool flush();
+
+  /*!
+    \brief Returns the number of batches evaluated so far
+  */
+  int getNumBatches() const { return m_batches; }
+
+ private:
+  // Default constructor not defined
+  EvaluatorQueue();
+
+  //! Scores the boards
+  BoardEvaluator& m_evaluator;
+
+  //! Resumes the waiting coroutines
+  GameScheduler& m_scheduler;
+
+  //! Requests waiting for the next flush
+  std::vector<Request*> m_pending;
+
+  //! Scratch arrays handed to the evaluator
+  std::vector<const Board*> m_boards;
+  std::vector<double> m_scores;
+
+  //! Number of flushes that had work
+  int m_batches;
+};
+
+} // namespace sage
+
+#endif
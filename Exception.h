@@ -14,7 +14,7 @@
 namespace sage {
 
 /*!
-  \brief Exception that's thrown by Board::applyMove when a move is invalid.
+  \brief Base class for all exceptions thrown by sage
 */
 class Exception : public std::exception
 {
@@ -30,6 +30,11 @@ class Exception : public std::exception
     ;
   }
 
+  /*!
+    \brief Returns the message this exception was created with
+  */
+  virtual const char* what() const throw () { return m_msg.c_str(); }
+
  private:
   std::string m_msg;
 };
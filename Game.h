@@ -17,6 +17,14 @@
 #include "sage/State.h"
 #endif
 
+#ifndef INCLUDED_sage_Zobrist_h
+#include "sage/Zobrist.h"
+#endif
+
+#ifndef INCLUDED_std_vector
+#include <vector>
+#endif
+
 namespace sage {
 
 /*!
@@ -25,11 +33,22 @@ namespace sage {
   A chess game consists of a starting position (Board), a series of moves,
   and a current position.
 
-  Note that the state is not figured out by this class, but must be 
-  calculated and set externally. Therefore it is possible to have this
-  object in an inconsistent state--e.g. where the contained board is drawn
-  but the state is STATE_ongoing. It is the responsibility of the objects
-  manipulating this class to enforce consistent state.
+  The state is calculated whenever a move is made. The legal moves and
+  check status found along the way are kept, so that whoever picks the next
+  move does not have to generate them again. Besides checkmate, stalemate
+  and bare kings, the game is drawn by threefold repetition and by the
+  fifty-move rule.
+
+  Repetitions are found with a history of position hashes. A capture or
+  pawn move can never be undone, so only the positions since the last one
+  need to be compared, and only those with the same side to move. The
+  fifty-move rule caps that at 50 comparisons per move.
+
+  The state can also be set externally (e.g. on resignation), so it is
+  possible to have this object in an inconsistent state--e.g. where the
+  contained board is drawn but the state is STATE_ongoing. It is the
+  responsibility of the objects manipulating this class to enforce
+  consistent state.
 */
 class Game
 {
@@ -44,9 +63,12 @@ class Game
   */
   Game(const Board& board)
     : m_initialBoard(board), m_currentBoard(board), m_moves(), 
-    m_state(BoardUtil::calculateState(board))
+    m_legalMoves(), m_legalBuffer(), m_inCheck(false), m_history(),
+    m_irreversible(0), m_repetitions(1), m_state(STATE_ongoing),
+    m_reason(REASON_none)
   {
-    ;
+    recordPosition();
+    updateState();
   }
 
   /*!
@@ -74,7 +96,24 @@ class Game
     m_moves.push_back(move);
 
     // Update the board state
-    m_state = BoardUtil::calculateState(m_currentBoard);
+    recordPosition();
+    updateState();
+  }
+
+  /*!
+    \brief Makes one of the legal moves of the current position
+    \param index Index of the move in getLegalMoves()
+
+    This skips the checks done by applyMove(), since the move came from the
+    move generator. Use applyMove() for moves from outside input.
+  */
+  void applyLegalMove(int index)
+  {
+    m_moves.push_back(m_legalMoves[index]);
+    m_currentBoard.applyTrustedMove(m_legalBuffer[index]);
+
+    recordPosition();
+    updateState();
   }
 
   /*!
@@ -82,6 +121,31 @@ class Game
   */
   const MoveList& getMoveList() const { return m_moves; }
 
+  /*!
+    \brief Returns the legal moves in the current position
+
+    This is empty once the side to move is checkmated or stalemated. The
+    moves are only valid until the next move is made.
+  */
+  const MoveList& getLegalMoves() const { return m_legalMoves; }
+
+  /*!
+    \brief Returns one of the legal moves in packed form
+    \param index Index of the move in getLegalMoves()
+  */
+  PackedMove getLegalMove(int index) const { return m_legalBuffer[index]; }
+
+  /*!
+    \brief Returns whether the side to move is in check
+  */
+  bool isInCheck() const { return m_inCheck; }
+
+  /*!
+    \brief Returns how many times the current position has occurred
+    \return The count, including the current occurrence; at least 1
+  */
+  int getRepetitionCount() const { return m_repetitions; }
+
   /*!
     \brief Retruns the initial board
   */
@@ -97,15 +161,96 @@ class Game
   */
   State getState() const { return m_state; }
 
+  /*!
+    \brief Returns why the game ended
+    \return REASON_none while the state is STATE_ongoing
+  */
+  Reason getReason() const { return m_reason; }
+
   /*!
     \brief Sets the state of the board
+    \param state The new state
+    \param reason Why the game ended; REASON_none for STATE_ongoing
   */
-  void setState(State state) { m_state = state; }
+  void setState(State state, Reason reason = REASON_external)
+  {
+    m_state = state;
+    m_reason = ((state == STATE_ongoing) ? REASON_none : reason);
+  }
 
  private:
   // Default constructor not defined
   Game();
 
+  //! Constants for the draw rules
+  enum Constant
+  {
+    REPETITION_LIMIT = 3,   //!< Occurrences of a position that draw
+    FIFTY_MOVE_LIMIT = 100  //!< Halfmoves without progress that draw
+  };
+
+  /*!
+    \brief Adds the current board to the position history and counts how
+    often it has occurred
+  */
+  void recordPosition()
+  {
+    HashKey hash = m_currentBoard.getHash();
+
+    // nothing before a capture or pawn move can be repeated
+    if (m_currentBoard.getHalfmoveClock() == 0)
+    {
+      m_irreversible = m_history.size();
+    }
+
+    m_history.push_back(hash);
+
+    // compare against earlier positions with the same side to move
+    m_repetitions = 1;
+    for (size_t i = m_history.size() - 1; i >= m_irreversible + 2; i -= 2)
+    {
+      if (m_history[i - 2] == hash)
+      {
+        ++m_repetitions;
+      }
+    }
+  }
+
+  /*!
+    \brief Recalculates the legal moves, check status and state for the
+    current board
+  */
+  void updateState()
+  {
+    m_legalBuffer.clear();
+    BoardUtil::populateMoveList(m_currentBoard, m_legalBuffer, m_inCheck);
+    BoardUtil::convertMoveList(m_currentBoard, m_legalBuffer, m_legalMoves);
+    m_state = BoardUtil::calculateState(m_currentBoard, m_legalBuffer,
+                                        m_inCheck);
+
+    if (m_state != STATE_ongoing)
+    {
+      m_reason = (!m_legalBuffer.empty()
+                  ? REASON_insufficientMaterial
+                  : (m_inCheck ? REASON_checkmate : REASON_stalemate));
+    }
+    // checkmate on the last move takes precedence over the draw rules
+    else if (m_repetitions >= REPETITION_LIMIT)
+    {
+      m_state = STATE_draw;
+      m_reason = REASON_repetition;
+    }
+    else if (m_currentBoard.getHalfmoveClock() >= FIFTY_MOVE_LIMIT)
+    {
+      m_state = STATE_draw;
+      m_reason = REASON_fiftyMove;
+    }
+    else
+    {
+      m_reason = REASON_none;
+    }
+  }
+
   //! The initial board position. This is not modified after construction
   Board m_initialBoard;
 
@@ -119,8 +264,30 @@ class Game
   //! The vector of moves taking place in this game.
   MoveList m_moves;
 
+  //! Legal moves in the current position
+  MoveList m_legalMoves;
+
+  //! Legal moves in the current position, as made on the board
+  MoveBuffer<> m_legalBuffer;
+
+  //! Whether the side to move is in check
+  bool m_inCheck;
+
+  //! Hash of every position in the game, starting with the initial one
+  std::vector<HashKey> m_history;
+
+  //! Index in m_history of the first position since the last capture or
+  //! pawn move
+  size_t m_irreversible;
+
+  //! Number of times the current position has occurred
+  int m_repetitions;
+
   //! The state of the board
   State m_state;
+
+  //! Why the game ended; REASON_none while it is ongoing
+  Reason m_reason;
 };
 
 } // namespace sage
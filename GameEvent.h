@@ -0,0 +1,184 @@
+#ifndef INCLUDED_sage_GameEvent_h
+#define INCLUDED_sage_GameEvent_h
+
+#ifndef INCLUDED_sage_PackedMove_h
+#include "sage/PackedMove.h"
+#endif
+
+#ifndef INCLUDED_sage_State_h
+#include "sage/State.h"
+#endif
+
+#ifndef INCLUDED_std_stdint
+#include <stdint.h>
+#define INCLUDED_std_stdint
+#endif
+
+namespace sage {
+
+/*!
+  \brief Fixed size record of something that happened in a game
+
+  Engines describe each game as a start event, one move event per ply and
+  an end event. The record is plain data, so sinks can copy it into
+  buffers and write it out as it is.
+*/
+struct GameEvent
+{
+  //! Kinds of event
+  enum Type
+  {
+    TYPE_start = 0, //!< The game started
+    TYPE_move,      //!< A move was made
+    TYPE_end        //!< The game ended
+  };
+
+  uint32_t m_game;     //!< Id of the game, chosen by whoever runs it
+  uint16_t m_ply;      //!< Plies played before this event
+  uint16_t m_move;     //!< PackedMove::getData() of the move; TYPE_move only
+  uint16_t m_choice;   //!< Index of the move among the legal moves
+  uint8_t m_type;      //!< The Type
+  uint8_t m_state;     //!< The State; TYPE_end only
+  uint8_t m_reason;    //!< The Reason; TYPE_end only
+  uint8_t m_unused[3]; //!< Zero; pads the record to 16 bytes
+
+  /*!
+    \brief Returns a TYPE_start event
+    \param game Id of the game
+  */
+  static GameEvent makeStart(uint32_t game)
+  {
+    return make(TYPE_start, game, 0);
+  }
+
+  /*!
+    \brief Returns a TYPE_move event
+    \param game Id of the game
+    \param ply Plies played before the move
+    \param move The move
+    \param choice Index of the move among the legal moves
+  */
+  static GameEvent makeMove(uint32_t game, int ply, PackedMove move,
+                            int choice)
+  {
+    GameEvent event = make(TYPE_move, game, ply);
+    event.m_move = move.getData();
+    event.m_choice = static_cast<uint16_t>(choice);
+    return event;
+  }
+
+  /*!
+    \brief Returns a TYPE_end event
+    \param game Id of the game
+    \param ply Plies played in the game
+    \param state How the game ended
+    \param reason Why it ended
+  */
+  static GameEvent makeEnd(uint32_t game, int ply, State state,
+                           Reason reason)
+  {
+    GameEvent event = make(TYPE_end, game, ply);
+    event.m_state = static_cast<uint8_t>(state);
+    event.m_reason = static_cast<uint8_t>(reason);
+    return event;
+  }
+
+  /*!
+    \brief Returns an event with every other field zero
+  */
+  static GameEvent make(Type type, uint32_t game, int ply)
+  {
+    GameEvent event = GameEvent();
+    event.m_game = game;
+    event.m_ply = static_cast<uint16_t>(ply);
+    event.m_type = static_cast<uint8_t>(type);
+    return event;
+  }
+};
+
+/*!
+  \brief Interface class for receiving game events
+
+  An Engine hands every event of its game to a sink. One sink may be
+  shared by many engines, possibly on many threads, if the sink says it
+  is thread-safe.
+*/
+class GameEventSink
+{
+ public:
+
+  /*!
+    \brief Default constructor
+  */
+  GameEventSink()
+  {
+    ;
+  }
+
+  /*!
+    \brief Destructor
+  */
+  virtual ~GameEventSink()
+  {
+    ;
+  }
+
+  /*!
+    \brief Receives an event
+  */
+  virtual void record(const GameEvent& event) = 0;
+
+  /*!
+    \brief Makes sure every event recorded so far has been written out
+  */
+  virtual void flush()
+  {
+    ;
+  }
+
+ private:
+};
+
+/*!
+  \brief Sink that discards every event
+
+  This is what engines use unless given another sink. It is thread-safe.
+*/
+class NullEventSink : public GameEventSink
+{
+ public:
+
+  /*!
+    \brief Default constructor
+  */
+  NullEventSink()
+  {
+    ;
+  }
+
+  /*!
+    \brief Destructor
+  */
+  virtual ~NullEventSink()
+  {
+    ;
+  }
+
+  virtual void record(const GameEvent& event)
+  {
+    ;
+  }
+
+  /*!
+    \brief Returns a shared instance
+  */
+  static NullEventSink& getInstance()
+  {
+    static NullEventSink s_instance;
+    return s_instance;
+  }
+};
+
+} // namespace sage
+
+#endif
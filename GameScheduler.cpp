@@ -0,0 +1,105 @@
+#include "sage/GameScheduler.h"
+
+#ifndef INCLUDED_sage_Exception_h
+#include "sage/Exception.h"
+#endif
+
+namespace sage {
+
+GameScheduler::GameScheduler()
+  : m_tasks(), m_ready(), m_idleHandlers()
+{
+
+}
+
+GameScheduler::~GameScheduler()
+{
+
+}
+
+void GameScheduler::spawn(Task<void> task)
+{
+  m_ready.push_back(task.getHandle());
+  m_tasks.push_back(std::move(task));
+}
+
+void GameScheduler::addIdleHandler(const IdleHandler& handler)
+{
+  m_idleHandlers.push_back(handler);
+}
+
+void GameScheduler::run()
+{
+  while (!m_tasks.empty())
+  {
+    while (!m_ready.empty())
+    {
+      std::coroutine_handle<> handle = m_ready.front();
+      m_ready.pop_front();
+      handle.resume();
+    }
+
+    // sweeping once per round keeps the cost per resume constant
+    reap();
+    if (m_tasks.empty())
+    {
+      break;
+    }
+
+    // every handler gets a turn, so that all queues are flushed together
+    bool progress = false;
+    for (std::vector<IdleHandler>::iterator iter = m_idleHandlers.begin();
+         iter != m_idleHandlers.end();
+         ++iter)
+    {
+      progress = ((*iter)() || progress);
+    }
+
+    if (!progress && m_ready.empty())
+    {
+      throw Exception("GameScheduler: tasks are waiting on nothing");
+    }
+  }
+}
+
+void GameScheduler::reap()
+{
+  std::vector<Task<void> >::iterator out = m_tasks.begin();
+  Task<void> failed;
+
+  for (std::vector<Task<void> >::iterator iter = m_tasks.begin();
+       iter != m_tasks.end();
+       ++iter)
+  {
+    // once a task has failed, the rest (finished or not) are kept for the
+    // next call, so that no other failure is lost
+    if (!iter->isDone() || failed.getHandle())
+    {
+      if (out != iter)
+      {
+        *out = std::move(*iter);
+      }
+      ++out;
+      continue;
+    }
+
+    try
+    {
+      iter->getResult();
+    }
+    catch (...)
+    {
+      // kept until the survivors are compacted, then rethrown
+      failed = std::move(*iter);
+    }
+  }
+
+  m_tasks.erase(out, m_tasks.end());
+
+  if (failed.getHandle())
+  {
+    failed.getResult();
+  }
+}
+
+} // namespace sage
@@ -0,0 +1,150 @@
+#ifndef INCLUDED_sage_GameScheduler_h
+#define INCLUDED_sage_GameScheduler_h
+
+#ifndef INCLUDED_sage_Task_h
+#include "sage/Task.h"
+#endif
+
+#ifndef INCLUDED_std_coroutine
+#include <coroutine>
+#define INCLUDED_std_coroutine
+#endif
+
+#ifndef INCLUDED_std_deque
+#include <deque>
+#define INCLUDED_std_deque
+#endif
+
+#ifndef INCLUDED_std_functional
+#include <functional>
+#define INCLUDED_std_functional
+#endif
+
+#ifndef INCLUDED_std_vector
+#include <vector>
+#endif
+
+namespace sage {
+
+/*!
+  \brief Interleaves many coroutine games on the calling thread
+
+  Games (usually AsyncEngine::run()) are spawned as tasks and run() resumes
+  them in turn from a queue of ready coroutines. A game that waits on
+  batched work suspends; the code that completes the work posts it back
+  onto the ready queue.
+
+  When nothing is ready, run() calls the idle handlers. These complete
+  whatever work has been queued up in the meantime (see EvaluatorQueue),
+  so by then every game has submitted its next request and each batch is
+  as large as it can be. A handler returns whether it did anything.
+
+  A scheduler is not thread-safe; use one per thread.
+*/
+class GameScheduler
+{
+ public:
+
+  //! Completes queued work; returns whether there was any
+  typedef std::function<bool()> IdleHandler;
+
+  /*!
+    \brief Awaitable that moves the awaiting coroutine to the back of the
+    ready queue
+  */
+  class Yield
+  {
+   public:
+    explicit Yield(GameScheduler& scheduler)
+      : m_scheduler(scheduler)
+    {
+      ;
+    }
+
+    bool await_ready() const noexcept { return false; }
+
+    void await_suspend(std::coroutine_handle<> handle)
+    {
+      m_scheduler.post(handle);
+    }
+
+    void await_resume() const noexcept
+    {
+      ;
+    }
+
+   private:
+    GameScheduler& m_scheduler;
+  };
+
+  /*!
+    \brief Default constructor: builds an empty scheduler
+  */
+  GameScheduler();
+
+  /*!
+    \brief Destructor: destroys any unfinished tasks
+  */
+  virtual ~GameScheduler();
+
+  /*!
+    \brief Adds a task to be run
+    \param task The task; the scheduler takes ownership and starts it from
+    run()
+  */
+  void spawn(Task<void> task);
+
+  /*!
+    \brief Queues a suspended coroutine to be resumed by run()
+  */
+  void post(std::coroutine_handle<> handle) { m_ready.push_back(handle); }
+
+  /*!
+    \brief Returns an awaitable that lets the other ready tasks run first
+  */
+  Yield yield() { return Yield(*this); }
+
+  /*!
+    \brief Adds a handler called whenever no coroutine is ready
+  */
+  void addIdleHandler(const IdleHandler& handler);
+
+  /*!
+    \brief Returns the number of unfinished tasks
+  */
+  int getNumTasks() const { return static_cast<int>(m_tasks.size()); }
+
+  /*!
+    \brief Runs the tasks until all of them have finished
+
+    An exception thrown by a task is rethrown from here once the task has
+    finished; the other tasks are kept, and calling run() again carries on
+    with them. Each call rethrows at most one exception, so when several
+    tasks fail, each failure is reported by its own call. Throws Exception
+    if tasks are left that no coroutine or idle handler will ever resume.
+  */
+  void run();
+
+ private:
+
+  /*!
+    \brief Removes finished tasks, rethrowing the first exception found
+
+    The tasks after a failed one are all kept, so that a later call reports
+    any other failure.
+  */
+  void reap();
+
+  //! Unfinished tasks
+  std::vector<Task<void> > m_tasks;
+
+  //! Coroutines waiting to be resumed
+  std::deque<std::coroutine_handle<> > m_ready;
+
+  //! Called when nothing is ready
+  std::vector<IdleHandler> m_idleHandlers;
+};
+
+} // namespace sage
+
+#endif
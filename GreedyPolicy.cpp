@@ -0,0 +1,73 @@
+#include "sage/GreedyPolicy.h"
+
+#ifndef INCLUDED_sage_BoardUtil_h
+#include "sage/BoardUtil.h"
+#endif
+
+#ifndef INCLUDED_sage_EvaluatorQueue_h
+#include "sage/EvaluatorQueue.h"
+#endif
+
+#ifndef INCLUDED_sage_PackedMove_h
+#include "sage/PackedMove.h"
+#endif
+
+namespace sage {
+
+GreedyPolicy::GreedyPolicy(EvaluatorQueue& queue, uint64_t seed)
+  : m_queue(queue), m_random(seed)
+{
+
+}
+
+GreedyPolicy::~GreedyPolicy()
+{
+
+}
+
+Task<int> GreedyPolicy::decide(const Board& board, const MoveList& moveList)
+{
+  const bool white = (board.getTurn() == Board::COLOR_white);
+  const int count = static_cast<int>(moveList.size());
+
+  int best = 0;
+  double bestScore = 0.0;
+  int ties = 0;
+  for (int i = 0; i < count; ++i)
+  {
+    // the child lives in this frame, so it stays put while we wait
+    Board child(board);
+    child.applyTrustedMove(PackedMove::fromMove(moveList[i]));
+
+    double score;
+    if (!BoardUtil::hasLegalMove(child))
+    {
+      if (BoardUtil::inCheck(child, child.getTurn()))
+      {
+        co_return i;
+      }
+      score = 0.0;
+    }
+    else
+    {
+      score = co_await m_queue.evaluate(child);
+      score = (white ? score : -score);
+    }
+
+    // each of n equal moves is kept with chance 1/n
+    if ((ties == 0) || (score > bestScore))
+    {
+      best = i;
+      bestScore = score;
+      ties = 1;
+    }
+    else if ((score == bestScore) && (m_random.nextInt(++ties) == 0))
+    {
+      best = i;
+    }
+  }
+
+  co_return best;
+}
+
+} // namespace sage
@@ -0,0 +1,58 @@
+#ifndef INCLUDED_sage_GreedyPolicy_h
+#define INCLUDED_sage_GreedyPolicy_h
+
+#ifndef INCLUDED_sage_AsyncPolicy_h
+#include "sage/AsyncPolicy.h"
+#endif
+
+#ifndef INCLUDED_sage_Random_h
+#include "sage/Random.h"
+#endif
+
+namespace sage {
+
+class EvaluatorQueue;
+
+/*!
+  \brief Coroutine policy that plays the move leading to the best scored
+  position, looking one ply ahead
+
+  Each position a move leads to is scored through an EvaluatorQueue, so
+  the policies of every game on a GameScheduler have their positions
+  scored in one batch. A move that checkmates is played without asking
+  the evaluator, and one that stalemates scores as a draw. Moves that
+  score the same are chosen between at random, so that games from the
+  same position do not all repeat each other.
+*/
+class GreedyPolicy : public AsyncPolicy
+{
+ public:
+
+  /*!
+    \brief Constructor
+    \param queue Scores the positions; it must outlive the policy
+    \param seed Seed for choosing between moves that score the same
+  */
+  GreedyPolicy(EvaluatorQueue& queue, uint64_t seed);
+
+  /*!
+    \brief Destructor
+  */
+  virtual ~GreedyPolicy();
+
+  virtual Task<int> decide(const Board& board, const MoveList& moveList);
+
+ private:
+  // Default constructor not defined
+  GreedyPolicy();
+
+  //! Scores the positions
+  EvaluatorQueue& m_queue;
+
+  //! Chooses between moves that score the same
+  Random m_random;
+};
+
+} // namespace sage
+
+#endif
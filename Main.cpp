@@ -6,13 +6,320 @@
 #include "sage/Exception.h"
 #include "sage/BoardEvaluator.h"
 #include "sage/Policy.h"
+#include "sage/AlphaBetaPolicy.h"
+#include "sage/MaterialEvaluator.h"
+#include "sage/PackedMove.h"
+#include "sage/PolicyFactory.h"
 #include "sage/RandomPolicy.h"
 #include "sage/HumanPolicy.h"
 #include "sage/Engine.h"
+#include "sage/AsyncEngine.h"
+#include "sage/EvaluatorQueue.h"
+#include "sage/GameScheduler.h"
+#include "sage/GreedyPolicy.h"
+#include "sage/AsyncTextEventSink.h"
+#include "sage/BinaryEventSink.h"
+#include "sage/TextEventSink.h"
 #include "sage/State.h"
+#include "sage/ThreadPool.h"
+#include "sage/Tournament.h"
+#include "sage/TranspositionTable.h"
+
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace {
+
+  //! Games played by the tournament when no count is given
+  const int DEFAULT_TOURNAMENT_GAMES = 100;
+
+  //! Games played by the batch mode when no count is given
+  const int DEFAULT_BATCH_GAMES = 1000;
+
+  //! Depth searched by the search mode when none is given
+  const int DEFAULT_SEARCH_DEPTH = 8;
+
+  //! Size of the transposition table used by the search mode
+  const size_t SEARCH_TABLE_MEGABYTES = 64;
+
+  //! Node budget of each move of an alpha-beta tournament player
+  const uint64_t TOURNAMENT_NODES = 20000;
+
+  //! Ending of a tournament log name that asks for binary records
+  const std::string BINARY_LOG_SUFFIX = ".bin";
+
+  /*!
+    \brief Plays two players against each other on every core
+    \param games The number of games
+    \param seed The master seed; the same seed gives the same results
+    \param names The kind of each player, "random" or "alphabeta"
+    \param log File to write every move of every game to; none if empty.
+    A name ending in .bin gets BinaryEventSink records, any other name
+    gets text lines from an AsyncTextEventSink.
+  */
+  int runTournament(int games, uint64_t seed, const std::string names[2],
+                    const std::string& log)
+  {
+    sage::SeededPolicyFactory<sage::RandomPolicy> randomFactory;
+
+    sage::MaterialEvaluator evaluator;
+    sage::AlphaBetaPolicy::Settings searchSettings;
+    searchSettings.m_maxNodes = TOURNAMENT_NODES;
+    searchSettings.m_pawnScore = sage::MaterialEvaluator::getPawnScore();
+    sage::AlphaBetaPolicyFactory searchFactory(evaluator, searchSettings);
+
+    sage::Tournament::Settings settings;
+    settings.m_games = games;
+    settings.m_seed = seed;
+
+    // the sink is declared after the stream, so it is done writing first
+    std::ofstream logStream;
+    std::unique_ptr<sage::GameEventSink> sink;
+    if (!log.empty())
+    {
+      const bool binary = ((log.size() >= BINARY_LOG_SUFFIX.size())
+                           && !log.compare(log.size()
+                                           - BINARY_LOG_SUFFIX.size(),
+                                           std::string::npos,
+                                           BINARY_LOG_SUFFIX));
+      logStream.open(log.c_str(), std::ios::out | std::ios::trunc
+                     | (binary ? std::ios::binary : std::ios::openmode()));
+      if (!logStream)
+      {
+        std::cerr << "cannot open " << log << std::endl;
+        return 1;
+      }
+
+      if (binary)
+      {
+        sink.reset(new sage::BinaryEventSink(logStream));
+      }
+      else
+      {
+        sink.reset(new sage::AsyncTextEventSink(logStream));
+      }
+      settings.m_eventSink = sink.get();
+    }
+
+    sage::Tournament tournament(settings);
+    for (int i = 0; i < 2; ++i)
+    {
+      if ((names[i] != "random") && (names[i] != "alphabeta"))
+      {
+        std::cerr << "unknown player " << names[i] << std::endl;
+        return 1;
+      }
+
+      tournament.addPlayer(names[i] + std::to_string(i + 1),
+                           ((names[i] == "random")
+                            ? static_cast<sage::PolicyFactory&>(randomFactory)
+                            : searchFactory));
+    }
+
+    sage::ThreadPool pool;
+    tournament.run(pool);
+    if (sink)
+    {
+      sink->flush();
+    }
+
+    for (int i = 0; i < tournament.getNumPlayers(); ++i)
+    {
+      sage::Tournament::Standing standing = tournament.getStanding(i);
+      std::cout << tournament.getPlayerName(i)
+                << " +" << standing.m_wins
+                << " =" << standing.m_draws
+                << " -" << standing.m_losses
+                << " points " << standing.getPoints() << "\n";
+    }
+    std::cout << "errors " << tournament.getErrorCount() << std::endl;
+    return 0;
+  }
+
+  /*!
+    \brief Searches one position to a fixed depth and reports the speed
+    \param depth The depth to search to
+    \param threads The threads to search with
+    \param fen The position; the starting position if empty
+
+    The search has no node or time limit, so the time it reports is the
+    time to depth, which is what to compare across thread counts.
+  */
+  int runSearch(int depth, int threads, const std::string& fen)
+  {
+    sage::Board board;
+    if (fen.empty())
+    {
+      sage::BoardUtil::initializeBoard(board);
+    }
+    else
+    {
+      sage::BoardUtil::setFen(board, fen);
+    }
+
+    sage::MoveList moveList;
+    sage::BoardUtil::populateMoveList(board, moveList);
+    if (moveList.empty())
+    {
+      std::cerr << "no legal moves" << std::endl;
+      return 1;
+    }
+
+    sage::MaterialEvaluator evaluator;
+    sage::TranspositionTable table(SEARCH_TABLE_MEGABYTES);
+
+    sage::AlphaBetaPolicy::Settings settings;
+    settings.m_maxDepth = depth;
+    settings.m_maxNodes = 0;
+    settings.m_table = &table;
+    settings.m_threads = threads;
+    settings.m_pawnScore = sage::MaterialEvaluator::getPawnScore();
+
+    sage::AlphaBetaPolicy policy(evaluator, settings);
+    int choice = policy.decide(board, moveList);
+
+    std::cout << "move "
+              << sage::BoardUtil::getMoveString(
+                   sage::PackedMove::fromMove(moveList[choice]))
+              << " score " << policy.getScore()
+              << " depth " << policy.getDepth()
+              << " threads " << threads
+              << " nodes " << policy.getNodes()
+              << " seconds " << policy.getTotalSeconds()
+              << " nps " << static_cast<uint64_t>(policy.getNodesPerSecond())
+              << std::endl;
+    return 0;
+  }
+
+  /*!
+    \brief Plays greedy policies against random ones as coroutine games,
+    all interleaved on the calling thread
+    \param games The number of games; the greedy policy is white in every
+    other one
+    \param seed The master seed; the same seed gives the same results
+
+    The greedy policies have their positions scored through one
+    EvaluatorQueue, so each batch holds a position from every game that is
+    waiting on the evaluator.
+  */
+  int runBatch(int games, uint64_t seed)
+  {
+    sage::MaterialEvaluator evaluator;
+    sage::GameScheduler scheduler;
+    sage::EvaluatorQueue queue(evaluator, scheduler);
+
+    sage::Board board;
+    sage::BoardUtil::initializeBoard(board);
+
+    std::vector<std::unique_ptr<sage::GreedyPolicy> > greedy;
+    std::vector<std::unique_ptr<sage::RandomPolicy> > random;
+    std::vector<std::unique_ptr<sage::SyncPolicyAdapter> > adapters;
+    std::vector<std::unique_ptr<sage::AsyncEngine> > engines;
+    for (int game = 0; game < games; ++game)
+    {
+      greedy.emplace_back(new sage::GreedyPolicy(
+                            queue, sage::Random::deriveSeed(seed, 2 * game)));
+      random.emplace_back(new sage::RandomPolicy(
+                            sage::Random::deriveSeed(seed, 2 * game + 1)));
+      adapters.emplace_back(new sage::SyncPolicyAdapter(*random.back()));
+
+      sage::AsyncPolicy& greedyPolicy = *greedy.back();
+      sage::AsyncPolicy& randomPolicy = *adapters.back();
+      const bool greedyWhite = ((game % 2) == 0);
+      engines.emplace_back(new sage::AsyncEngine(
+                             (greedyWhite ? greedyPolicy : randomPolicy),
+                             (greedyWhite ? randomPolicy : greedyPolicy),
+                             board));
+      scheduler.spawn(engines.back()->run());
+    }
+
+    scheduler.run();
+
+    int wins = 0;
+    int draws = 0;
+    int losses = 0;
+    for (int game = 0; game < games; ++game)
+    {
+      const State state = engines[game]->getGame().getState();
+      if (state == STATE_draw)
+      {
+        ++draws;
+      }
+      else if ((state == STATE_whiteWon) == ((game % 2) == 0))
+      {
+        ++wins;
+      }
+      else
+      {
+        ++losses;
+      }
+    }
+
+    std::cout << "greedy +" << wins << " =" << draws << " -" << losses
+              << " batches " << queue.getNumBatches() << std::endl;
+    return 0;
+  }
+
+} // anonymous namespace
 
 int main(int argc, char** argv)
 {
+  if ((argc > 1) && !strcmp(argv[1], "tournament"))
+  {
+    // sage tournament [games] [seed] [player1] [player2] [log]
+    const std::string names[2] = { ((argc > 4) ? argv[4] : "random"),
+                                   ((argc > 5) ? argv[5] : "random") };
+    return runTournament(((argc > 2) 
+                          ? atoi(argv[2]) 
+                          : DEFAULT_TOURNAMENT_GAMES),
+                         ((argc > 3) ? strtoull(argv[3], 0, 0) : 0),
+                         names,
+                         ((argc > 6) ? argv[6] : ""));
+  }
+
+  if ((argc > 1) && !strcmp(argv[1], "batch"))
+  {
+    // sage batch [games] [seed]
+    try
+    {
+      return runBatch(((argc > 2) ? atoi(argv[2]) : DEFAULT_BATCH_GAMES),
+                      ((argc > 3) ? strtoull(argv[3], 0, 0) : 0));
+    }
+    catch (const sage::Exception& e)
+    {
+      std::cerr << e.what() << std::endl;
+      return 1;
+    }
+  }
+
+  if ((argc > 1) && !strcmp(argv[1], "search"))
+  {
+    // sage search [depth] [threads] [fen fields...]
+    std::string fen;
+    for (int i = 4; i < argc; ++i)
+    {
+      fen += ((i > 4) ? " " : "");
+      fen += argv[i];
+    }
+
+    try
+    {
+      return runSearch(((argc > 2) ? atoi(argv[2]) : DEFAULT_SEARCH_DEPTH),
+                       ((argc > 3) ? atoi(argv[3]) : 1),
+                       fen);
+    }
+    catch (const sage::Exception& e)
+    {
+      std::cerr << e.what() << std::endl;
+      return 1;
+    }
+  }
+
   // get board starting position
   sage::Board board;
   sage::BoardUtil::initializeBoard(board);
@@ -20,7 +327,12 @@ int main(int argc, char** argv)
   sage::HumanPolicy whitePolicy;
   sage::HumanPolicy blackPolicy;
 
+  // the human policies prompt on std::cout, so the log is written there
+  // as it happens rather than from another thread
+  sage::TextEventSink log(std::cout);
+
   sage::Engine gameEngine(whitePolicy, blackPolicy, board);
+  gameEngine.setEventSink(log);
 
   gameEngine.run();
   return 0;
@@ -0,0 +1,104 @@
+#include "sage/Material.h"
+
+namespace sage {
+
+MaterialKey
+Material::s_pieceKeys[Piece::NUM_TYPES][BitboardUtil::NUM_SQUARES];
+bool Material::s_deadDraw[Material::NUM_DEAD_KEYS];
+
+namespace {
+
+  //! Builds the tables before main() runs
+  class MaterialInitializer
+  {
+   public:
+    MaterialInitializer()
+    {
+      Material::initialize();
+    }
+  };
+
+  MaterialInitializer materialInitializer;
+
+  /*!
+    \brief Returns the class of a piece, or -1 for a king
+    \param index Piece::getIndex() of the piece type
+    \param light Whether the piece stands on a light square
+  */
+  int getClass(int index, bool light)
+  {
+    switch (Piece::getTypeFromIndex(index))
+    {
+    case Piece::PIECE_whiteQueen:
+      return Material::CLASS_whiteQueen;
+    case Piece::PIECE_whiteRook:
+      return Material::CLASS_whiteRook;
+    case Piece::PIECE_whiteBishop:
+      return (light
+              ? Material::CLASS_whiteLightBishop
+              : Material::CLASS_whiteDarkBishop);
+    case Piece::PIECE_whiteKnight:
+      return Material::CLASS_whiteKnight;
+    case Piece::PIECE_whitePawn:
+      return Material::CLASS_whitePawn;
+    case Piece::PIECE_blackQueen:
+      return Material::CLASS_blackQueen;
+    case Piece::PIECE_blackRook:
+      return Material::CLASS_blackRook;
+    case Piece::PIECE_blackBishop:
+      return (light
+              ? Material::CLASS_blackLightBishop
+              : Material::CLASS_blackDarkBishop);
+    case Piece::PIECE_blackKnight:
+      return Material::CLASS_blackKnight;
+    case Piece::PIECE_blackPawn:
+      return Material::CLASS_blackPawn;
+    default:
+      return -1;
+    }
+  }
+
+} // anonymous namespace
+
+void Material::initialize()
+{
+  for (int i = 0; i < Piece::NUM_TYPES; ++i)
+  {
+    for (int square = 0; square < BitboardUtil::NUM_SQUARES; ++square)
+    {
+      // a1 is a dark square
+      bool light = (((BitboardUtil::getColumn(square)
+                      + BitboardUtil::getRow(square)) & 1) != 0);
+      int pieceClass = getClass(i, light);
+      s_pieceKeys[i][square] = ((pieceClass < 0)
+                                ? 0
+                                : (static_cast<MaterialKey>(1)
+                                   << (pieceClass * CLASS_BITS)));
+    }
+  }
+
+  // each index packs the minor counts two bits per class, in class order
+  for (int index = 0; index < NUM_DEAD_KEYS; ++index)
+  {
+    int counts[NUM_MINOR_CLASSES];
+    for (int i = 0; i < NUM_MINOR_CLASSES; ++i)
+    {
+      counts[i] = ((index >> (2 * i)) & 0x3);
+    }
+
+    int knights = counts[CLASS_whiteKnight] + counts[CLASS_blackKnight];
+    int light = (counts[CLASS_whiteLightBishop]
+                 + counts[CLASS_blackLightBishop]);
+    int dark = (counts[CLASS_whiteDarkBishop]
+                + counts[CLASS_blackDarkBishop]);
+
+    // a mated king always has a flight square of the other color from
+    // bishops that all stand on one color, and a lone knight cannot cover
+    // enough squares; any other combination can mate with help
+    s_deadDraw[index] = ((knights == 0)
+                         ? ((light == 0) || (dark == 0))
+                         : ((knights == 1) && (light == 0) && (dark == 0)));
+  }
+}
+
+} // namespace sage
@@ -0,0 +1,137 @@
+#ifndef INCLUDED_sage_Material_h
+#define INCLUDED_sage_Material_h
+
+#ifndef INCLUDED_sage_Piece_h
+#include "sage/Piece.h"
+#endif
+
+#ifndef INCLUDED_sage_Bitboard_h
+#include "sage/Bitboard.h"
+#endif
+
+#ifndef INCLUDED_std_stdint
+#include <stdint.h>
+#define INCLUDED_std_stdint
+#endif
+
+namespace sage {
+
+//! Packed count of the pieces of each class on the board
+typedef uint64_t MaterialKey;
+
+/*!
+  \brief Material signatures and dead-draw detection
+
+  A material key holds a 4 bit count for each class of piece other than
+  the kings. Bishops are split into two classes by the color of their
+  square, since that decides whether a set of bishops can ever mate. Adding
+  a piece adds its class's unit to the key and removing it subtracts it, so
+  Board keeps the key up to date as cheaply as its Zobrist hashes.
+
+  The classes are laid out so that the knights and bishops come first.
+  Positions where mate is impossible for both sides (bare kings, a single
+  knight, or bishops that all stand on one color) have no pawns, rooks or
+  queens. With at most three pieces in each minor class their keys fit in
+  12 bits, and a table of that size answers whether the position is dead
+  with a single lookup. Four or more bishops on one color take several
+  promotions, so such positions are simply played on.
+
+  All methods are declared static so you don't have to instantiate this
+  class.
+*/
+class Material
+{
+ public:
+
+  //! Piece classes counted by the key; each is one 4 bit field
+  enum PieceClass
+  {
+    CLASS_whiteKnight = 0,
+    CLASS_whiteLightBishop,
+    CLASS_whiteDarkBishop,
+    CLASS_blackKnight,
+    CLASS_blackLightBishop,
+    CLASS_blackDarkBishop,
+    CLASS_whitePawn,
+    CLASS_whiteRook,
+    CLASS_whiteQueen,
+    CLASS_blackPawn,
+    CLASS_blackRook,
+    CLASS_blackQueen,
+    NUM_CLASSES
+  };
+
+  //! Constants defined by the key layout
+  enum Constant
+  {
+    CLASS_BITS = 4,            //!< Width of each count
+    NUM_MINOR_CLASSES = 6,     //!< Knight and bishop classes at the bottom
+    NUM_DEAD_KEYS = 0x1000,    //!< Entries of the dead-draw table
+    MINOR_LOW_BITS = 0x333333  //!< Low two bits of each minor class count
+  };
+
+  /*!
+    \brief Returns the amount a piece adds to the material key
+    \param index Piece::getIndex() of the piece type
+    \param square The square the piece is on
+    \return The unit of the piece's class; 0 for kings
+  */
+  static MaterialKey getPieceKey(int index, int square)
+  {
+    return s_pieceKeys[index][square];
+  }
+
+  /*!
+    \brief Returns the number of pieces of a class in a key
+  */
+  static int getCount(MaterialKey key, PieceClass pieceClass)
+  {
+    int shift = static_cast<int>(pieceClass) * CLASS_BITS;
+    return static_cast<int>((key >> shift) & 0xf);
+  }
+
+  /*!
+    \brief Returns whether neither side can checkmate with this material
+    \param key Board::getMaterialKey() of the position
+    \retval true If the position is drawn whatever the moves
+    \retval false If some sequence of moves leads to mate
+
+    Positions that are dead only because of where the pawns stand (e.g.
+    fully blocked), or that have four or more bishops of one class, are
+    not recognised.
+  */
+  static bool isDeadDraw(MaterialKey key)
+  {
+    // anything other than a few minor pieces can still mate
+    if (key & ~static_cast<MaterialKey>(MINOR_LOW_BITS))
+    {
+      return false;
+    }
+
+    // squeeze the six 2 bit minor counts together
+    uint32_t low = static_cast<uint32_t>(key);
+    uint32_t index = ((low & 0x3) | ((low >> 2) & 0xc) | ((low >> 4) & 0x30)
+                      | ((low >> 6) & 0xc0) | ((low >> 8) & 0x300)
+                      | ((low >> 10) & 0xc00));
+    return s_deadDraw[index];
+  }
+
+  /*!
+    \brief Builds the tables
+
+    This is called automatically at program startup.
+  */
+  static void initialize();
+
+ private:
+
+  //! Class units, indexed by Piece::getIndex() and square
+  static MaterialKey s_pieceKeys[Piece::NUM_TYPES][BitboardUtil::NUM_SQUARES];
+
+  //! Whether each packed set of minor piece counts is a dead draw
+  static bool s_deadDraw[NUM_DEAD_KEYS];
+};
+
+} // namespace sage
+
+#endif
@@ -0,0 +1,63 @@
+#include "sage/MaterialEvaluator.h"
+
+#ifndef INCLUDED_sage_Board_h
+#include "sage/Board.h"
+#endif
+
+#ifndef INCLUDED_sage_BoardUtil_h
+#include "sage/BoardUtil.h"
+#endif
+
+namespace sage {
+
+namespace {
+
+  //! Centipawns that score 1.0
+  const double SCALE = 4000.0;
+
+  //! Bound on the score, so that material never looks like a forced win
+  const double MAX_SCORE = 0.99;
+
+} // anonymous namespace
+
+MaterialEvaluator::MaterialEvaluator()
+{
+
+}
+
+MaterialEvaluator::~MaterialEvaluator()
+{
+
+}
+
+double MaterialEvaluator::evaluate(const Board& board)
+{
+  // the kings (index 0 and 6) are always there and cancel out
+  int balance = 0;
+  for (int index = 1; index < 6; ++index)
+  {
+    Piece::Type white = Piece::getTypeFromIndex(index);
+    Piece::Type black = Piece::getTypeFromIndex(index + 6);
+    balance += (BoardUtil::getPieceValue(white)
+                * (BitboardUtil::popCount(board.getPieces(white))
+                   - BitboardUtil::popCount(board.getPieces(black))));
+  }
+
+  double score = balance / SCALE;
+  if (score > MAX_SCORE)
+  {
+    return MAX_SCORE;
+  }
+  if (score < -MAX_SCORE)
+  {
+    return -MAX_SCORE;
+  }
+  return score;
+}
+
+double MaterialEvaluator::getPawnScore()
+{
+  return BoardUtil::getPieceValue(Piece::PIECE_whitePawn) / SCALE;
+}
+
+} // namespace sage
@@ -0,0 +1,47 @@
+#ifndef INCLUDED_sage_MaterialEvaluator_h
+#define INCLUDED_sage_MaterialEvaluator_h
+
+#ifndef INCLUDED_sage_BoardEvaluator_h
+#include "sage/BoardEvaluator.h"
+#endif
+
+namespace sage {
+
+/*!
+  \brief Evaluator that counts material and nothing else
+
+  Each side's pieces are valued as by BoardUtil::getPieceValue() and the
+  difference is scaled so that 4000 centipawns, about a full set of
+  pieces, score 1.0; scores are kept just below 1.0, since material alone
+  is no forced win. It is the simplest evaluator a search can be run with,
+  e.g. to measure the search's own speed.
+
+  The evaluator keeps no state, so any number of threads may use it at
+  once.
+*/
+class MaterialEvaluator : public BoardEvaluator
+{
+ public:
+
+  /*!
+    \brief Default constructor
+  */
+  MaterialEvaluator();
+
+  /*!
+    \brief Destructor
+  */
+  virtual ~MaterialEvaluator();
+
+  virtual double evaluate(const Board& board);
+
+  /*!
+    \brief Returns what a pawn is worth in evaluate()'s units, e.g. for
+    AlphaBetaPolicy::Settings::m_pawnScore
+  */
+  static double getPawnScore();
+};
+
+} // namespace sage
+
+#endif
@@ -0,0 +1,114 @@
+#ifndef INCLUDED_sage_MoveBuffer_h
+#define INCLUDED_sage_MoveBuffer_h
+
+#ifndef INCLUDED_sage_PackedMove_h
+#include "sage/PackedMove.h"
+#endif
+
+#ifndef INCLUDED_std_cassert
+#include <cassert>
+#define INCLUDED_std_cassert
+#endif
+
+namespace sage {
+
+/*!
+  \brief Fixed-capacity list of packed moves
+
+  The moves are stored inline, so a buffer declared as a local variable
+  lives entirely on the stack and filling it never touches the heap. The
+  default capacity of 256 is more than the number of legal moves in any
+  chess position (218), so a buffer can always hold the output of
+  BoardUtil::populateMoveList.
+
+  The interface follows the subset of std::vector that move generation
+  needs; pushing past the capacity is a programming error.
+*/
+template <int CAPACITY = 256>
+class MoveBuffer
+{
+ public:
+
+  //! Iterator over the moves
+  typedef PackedMove* iterator;
+
+  //! Const iterator over the moves
+  typedef const PackedMove* const_iterator;
+
+  /*!
+    \brief Default constructor: builds an empty buffer
+  */
+  MoveBuffer()
+    : m_size(0)
+  {
+    ;
+  }
+
+  /*!
+    \brief Appends a move
+    \param move The move to append
+  */
+  void push_back(PackedMove move)
+  {
+    assert(m_size < CAPACITY);
+    m_moves[m_size++] = move;
+  }
+
+  /*!
+    \brief Removes all moves
+  */
+  void clear() { m_size = 0; }
+
+  /*!
+    \brief Returns the number of moves
+  */
+  int size() const { return m_size; }
+
+  /*!
+    \brief Returns whether the buffer has no moves
+  */
+  bool empty() const { return (m_size == 0); }
+
+  /*!
+    \brief Returns the maximum number of moves
+  */
+  static int capacity() { return CAPACITY; }
+
+  /*!
+    \brief Returns the move at the given index
+  */
+  PackedMove& operator[](int index) { return m_moves[index]; }
+
+  /*!
+    \brief Returns the move at the given index
+  */
+  const PackedMove& operator[](int index) const { return m_moves[index]; }
+
+  /*!
+    \brief Returns the last move
+  */
+  PackedMove& back() { return m_moves[m_size - 1]; }
+
+  //! Returns an iterator to the first move
+  iterator begin() { return m_moves; }
+
+  //! Returns an iterator past the last move
+  iterator end() { return (m_moves + m_size); }
+
+  //! Returns an iterator to the first move
+  const_iterator begin() const { return m_moves; }
+
+  //! Returns an iterator past the last move
+  const_iterator end() const { return (m_moves + m_size); }
+
+ private:
+  //! Number of moves in use
+  int m_size;
+
+  //! Storage; only the first m_size entries are valid
+  PackedMove m_moves[CAPACITY];
+};
+
+} // namespace sage
+
+#endif
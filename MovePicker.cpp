@@ -0,0 +1,280 @@
+#include "sage/MovePicker.h"
+
+#ifndef INCLUDED_sage_BoardUtil_h
+#include "sage/BoardUtil.h"
+#endif
+
+namespace sage {
+
+namespace {
+
+  //! Ranks of the pieces for MVV-LVA by Piece::getIndex() % 6: king,
+  //! queen, rook, bishop, knight, pawn. A victim outranks any attacker.
+  const int PIECE_RANKS[6] = { 6, 5, 4, 3, 3, 1 };
+
+  //! Multiplier that puts the victim's rank above the attacker's
+  const int VICTIM_WEIGHT = 8;
+
+  //! Returns the MVV-LVA rank of the piece on a square
+  int getRank(const Board& board, int square)
+  {
+    return PIECE_RANKS[Piece::getIndex(board.getPieceType(square)) % 6];
+  }
+
+  //! Returns the MVV-LVA rank of what a tactical move captures; a
+  //! promotion counts as capturing the piece it promotes to
+  int getVictimRank(const Board& board, PackedMove move)
+  {
+    int victim = (move.isEnPassant()
+                  ? PIECE_RANKS[Piece::getIndex(Piece::PIECE_whitePawn)]
+                  : (move.isCapture() ? getRank(board, move.getTo()) : 0));
+    if (move.isPromotion())
+    {
+      victim += PIECE_RANKS[Piece::getIndex(move.getPromotionType(0))];
+    }
+
+    return victim;
+  }
+
+} // anonymous namespace
+
+void MoveHistory::clear()
+{
+  for (int color = 0; color < 2; ++color)
+  {
+    for (int from = 0; from < 64; ++from)
+    {
+      for (int to = 0; to < 64; ++to)
+      {
+        m_scores[color][from][to] = 0;
+      }
+    }
+  }
+
+  for (int ply = 0; ply < MAX_PLY; ++ply)
+  {
+    for (int slot = 0; slot < NUM_KILLERS; ++slot)
+    {
+      m_killers[ply][slot] = PackedMove(0, 0, PackedMove::FLAG_quiet);
+    }
+  }
+}
+
+void MoveHistory::update(int colorIndex, int ply, int depth, PackedMove move,
+                         const MoveBuffer<>& tried)
+{
+  if ((ply < MAX_PLY) && (m_killers[ply][0] != move))
+  {
+    m_killers[ply][1] = m_killers[ply][0];
+    m_killers[ply][0] = move;
+  }
+
+  // deeper cutoffs save more work, so they count for more
+  const int bonus = ((depth * depth < MAX_BONUS) ? depth * depth : MAX_BONUS);
+
+  adjust(m_scores[colorIndex][move.getFrom()][move.getTo()], bonus);
+  for (MoveBuffer<>::const_iterator iter = tried.begin();
+       iter != tried.end();
+       ++iter)
+  {
+    adjust(m_scores[colorIndex][iter->getFrom()][iter->getTo()], -bonus);
+  }
+}
+
+MovePicker::MovePicker(const Board& board, PackedMove hashMove,
+                       const MoveHistory& history, int ply)
+  : m_board(board), m_history(&history), m_hashMove(hashMove),
+    m_stage(STAGE_hashMove), m_moves(), m_next(0), m_losing()
+{
+  for (int slot = 0; slot < MoveHistory::NUM_KILLERS; ++slot)
+  {
+    m_killers[slot] = history.getKiller(ply, slot);
+  }
+}
+
+MovePicker::MovePicker(const Board& board)
+  : m_board(board), m_history(0),
+    m_hashMove(0, 0, PackedMove::FLAG_quiet),
+    m_stage(STAGE_generateTactical), m_moves(), m_next(0), m_losing()
+{
+  for (int slot = 0; slot < MoveHistory::NUM_KILLERS; ++slot)
+  {
+    m_killers[slot] = m_hashMove;
+  }
+}
+
+MovePicker::~MovePicker()
+{
+
+}
+
+bool MovePicker::next(PackedMove& move)
+{
+  switch (m_stage)
+  {
+  case STAGE_hashMove:
+    m_stage = STAGE_generateTactical;
+    if ((m_hashMove.getData() != 0)
+        && BoardUtil::isLegalMove(m_board, m_hashMove))
+    {
+      move = m_hashMove;
+      return true;
+    }
+    [[fallthrough]];
+
+  case STAGE_generateTactical:
+    BoardUtil::populateMoveList(m_board, BoardUtil::MOVES_tactical,
+                                m_moves);
+    for (int i = 0; i < m_moves.size(); ++i)
+    {
+      m_scores[i] = ((getVictimRank(m_board, m_moves[i]) * VICTIM_WEIGHT)
+                     - getRank(m_board, m_moves[i].getFrom()));
+    }
+    m_next = 0;
+    m_stage = STAGE_tactical;
+    [[fallthrough]];
+
+  case STAGE_tactical:
+    while (pickBest(move))
+    {
+      if (move == m_hashMove)
+      {
+        continue;
+      }
+
+      // an under-promotion is almost never better than a queen, so a
+      // quiescence search does not spend nodes on it
+      if (!m_history && move.isPromotion()
+          && (move.getPromotionType(0) != Piece::PIECE_whiteQueen))
+      {
+        continue;
+      }
+
+      // losing moves come after the quiet ones, or not at all in a
+      // quiescence search
+      if (isLosing(move))
+      {
+        if (m_history)
+        {
+          m_losing.push_back(move);
+        }
+        continue;
+      }
+
+      return true;
+    }
+    if (!m_history)
+    {
+      m_stage = STAGE_done;
+      return false;
+    }
+    m_next = 0;
+    m_stage = STAGE_killers;
+    [[fallthrough]];
+
+  case STAGE_killers:
+    while (m_next < MoveHistory::NUM_KILLERS)
+    {
+      // a tactical killer was already handed out with the captures
+      move = m_killers[m_next++];
+      if ((move.getData() != 0) && !move.isTactical() && (move != m_hashMove)
+          && BoardUtil::isLegalMove(m_board, move))
+      {
+        return true;
+      }
+    }
+    m_stage = STAGE_generateQuiet;
+    [[fallthrough]];
+
+  case STAGE_generateQuiet:
+    {
+      BoardUtil::populateMoveList(m_board, BoardUtil::MOVES_quiet, m_moves);
+      const int us = Board::getColorIndex(m_board.getTurn());
+      for (int i = 0; i < m_moves.size(); ++i)
+      {
+        m_scores[i] = m_history->getScore(us, m_moves[i]);
+      }
+      m_next = 0;
+      m_stage = STAGE_quiet;
+    }
+    [[fallthrough]];
+
+  case STAGE_quiet:
+    while (pickBest(move))
+    {
+      if (!isSpecial(move))
+      {
+        return true;
+      }
+    }
+    m_next = 0;
+    m_stage = STAGE_losing;
+    [[fallthrough]];
+
+  case STAGE_losing:
+    if (m_next < m_losing.size())
+    {
+      move = m_losing[m_next++];
+      return true;
+    }
+    m_stage = STAGE_done;
+    [[fallthrough]];
+
+  default:
+    return false;
+  }
+}
+
+bool MovePicker::pickBest(PackedMove& move)
+{
+  if (m_next >= m_moves.size())
+  {
+    return false;
+  }
+
+  // a selection sort, one step per move; a cutoff leaves the rest unsorted
+  int best = m_next;
+  for (int i = m_next + 1; i < m_moves.size(); ++i)
+  {
+    if (m_scores[i] > m_scores[best])
+    {
+      best = i;
+    }
+  }
+
+  move = m_moves[best];
+  m_moves[best] = m_moves[m_next];
+  m_scores[best] = m_scores[m_next];
+  ++m_next;
+  return true;
+}
+
+bool MovePicker::isLosing(PackedMove move) const
+{
+  // the promoted piece may be lost on the end square, so a promotion is
+  // always worked out, even though it outranks the pawn
+  return ((move.isPromotion()
+           || (getRank(m_board, move.getFrom())
+               > getVictimRank(m_board, move)))
+          && (BoardUtil::getExchangeValue(m_board, move) < 0));
+}
+
+bool MovePicker::isSpecial(PackedMove move) const
+{
+  if (move == m_hashMove)
+  {
+    return true;
+  }
+
+  for (int slot = 0; slot < MoveHistory::NUM_KILLERS; ++slot)
+  {
+    if (move == m_killers[slot])
+    {
+      return true;
+    }
+  }
+
+  return false;
+}
+
+} // namespace sage
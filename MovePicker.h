@@ -0,0 +1,252 @@
+#ifndef INCLUDED_sage_MovePicker_h
+#define INCLUDED_sage_MovePicker_h
+
+#ifndef INCLUDED_sage_Board_h
+#include "sage/Board.h"
+#endif
+
+#ifndef INCLUDED_sage_MoveBuffer_h
+#include "sage/MoveBuffer.h"
+#endif
+
+#ifndef INCLUDED_sage_PackedMove_h
+#include "sage/PackedMove.h"
+#endif
+
+namespace sage {
+
+/*!
+  \brief What a search has learned about which quiet moves cut off
+
+  Two things are kept. The killer moves are the last two quiet moves that
+  caused a cutoff at each ply; sibling positions often fall to the same
+  move. The history (also known as the butterfly table) scores every
+  start and end square pair for each side: a quiet move that cuts off
+  gains, and the quiet moves tried before it lose. Scores are kept within
+  MAX_SCORE by shrinking each update as the score approaches the limit.
+
+  A history belongs to one search thread.
+*/
+class MoveHistory
+{
+ public:
+
+  //! Constants used by the history
+  enum Constant
+  {
+    MAX_PLY = 128,      //!< Plies for which killers are kept
+    NUM_KILLERS = 2,    //!< Killers kept per ply
+    MAX_SCORE = 0x4000, //!< Bound on the absolute history score
+    MAX_BONUS = 0x400   //!< Bound on a single update
+  };
+
+  /*!
+    \brief Default constructor: an empty history
+  */
+  MoveHistory()
+  {
+    clear();
+  }
+
+  /*!
+    \brief Destructor
+  */
+  virtual ~MoveHistory()
+  {
+    ;
+  }
+
+  /*!
+    \brief Forgets everything
+  */
+  void clear();
+
+  /*!
+    \brief Returns the history score of a move
+    \param colorIndex Board::getColorIndex() of the side making the move
+    \param move The move
+  */
+  int getScore(int colorIndex, PackedMove move) const
+  {
+    return m_scores[colorIndex][move.getFrom()][move.getTo()];
+  }
+
+  /*!
+    \brief Returns a killer move
+    \param ply Plies from the root
+    \param slot 0 for the most recent killer, 1 for the one before
+    \return The killer; all bits zero if there is none
+  */
+  PackedMove getKiller(int ply, int slot) const
+  {
+    return ((ply < MAX_PLY)
+            ? m_killers[ply][slot]
+            : PackedMove(0, 0, PackedMove::FLAG_quiet));
+  }
+
+  /*!
+    \brief Records a cutoff by a quiet move
+    \param colorIndex Board::getColorIndex() of the side that moved
+    \param ply Plies from the root
+    \param depth Plies that were left to search
+    \param move The move that cut off
+    \param tried The quiet moves tried before it, which did not
+  */
+  void update(int colorIndex, int ply, int depth, PackedMove move,
+              const MoveBuffer<>& tried);
+
+ private:
+
+  /*!
+    \brief Moves a history score towards a bonus or penalty
+  */
+  static void adjust(int& score, int bonus)
+  {
+    score += bonus - ((score * (bonus < 0 ? -bonus : bonus)) / MAX_SCORE);
+  }
+
+  //! History scores by side, start square and end square
+  int m_scores[2][64][64];
+
+  //! Killer moves by ply, most recent first
+  PackedMove m_killers[MAX_PLY][NUM_KILLERS];
+};
+
+/*!
+  \brief Hands out the legal moves of a position, most promising first
+
+  The moves come in stages:
+
+  -# The hash move, i.e. the best move stored in the transposition table
+  -# Captures and promotions, most valuable victim first and, among those,
+     least valuable attacker first (MVV-LVA)
+  -# The killer moves of the ply
+  -# The other quiet moves, highest history score first
+  -# The tactical moves that lose material, as judged by
+     BoardUtil::getExchangeValue()
+
+  Each stage only generates its moves when the one before is used up, so
+  a search that cuts off early never generates the quiet moves at all.
+  The hash move and killers are checked for legality, since they come
+  from other positions, and are not handed out twice.
+
+  A picker made for a quiescence search hands out only the tactical moves
+  that do not lose material, with no hash move or killers. Of the
+  promotions it hands out only those to a queen.
+
+  The picker refers to the board and history it was given; both must stay
+  as they are while it is in use, apart from moves made and taken back
+  between calls to next().
+*/
+class MovePicker
+{
+ public:
+
+  /*!
+    \brief Constructor
+    \param board The position
+    \param hashMove The move to try first; all bits zero if none
+    \param history Supplies the killers and quiet move scores
+    \param ply Plies from the root, for the killers
+  */
+  MovePicker(const Board& board, PackedMove hashMove,
+             const MoveHistory& history, int ply);
+
+  /*!
+    \brief Constructor for a quiescence search: only the tactical moves
+    that do not lose material are handed out, and no under-promotions
+    \param board The position
+  */
+  explicit MovePicker(const Board& board);
+
+  /*!
+    \brief Destructor
+  */
+  virtual ~MovePicker();
+
+  /*!
+    \brief Returns the next move to try
+    \param move [out] The move
+    \retval true If there was one
+    \retval false If every legal move has been handed out
+  */
+  bool next(PackedMove& move);
+
+ private:
+  // Default constructor not defined
+  MovePicker();
+
+  //! Constants used by the picker
+  enum Constant
+  {
+    MAX_MOVES = 256 //!< Capacity of the move buffer
+  };
+
+  //! Stages the picker goes through, in order
+  enum Stage
+  {
+    STAGE_hashMove = 0,     //!< Hand out the hash move
+    STAGE_generateTactical, //!< Generate and score the tactical moves
+    STAGE_tactical,         //!< Hand out the tactical moves
+    STAGE_killers,          //!< Hand out the killers
+    STAGE_generateQuiet,    //!< Generate and score the quiet moves
+    STAGE_quiet,            //!< Hand out the quiet moves
+    STAGE_losing,           //!< Hand out the tactical moves that lose
+    STAGE_done              //!< Nothing left
+  };
+
+  /*!
+    \brief Takes the best scored move not yet handed out
+    \param move [out] The move
+    \retval true If there was one
+    \retval false If the generated moves are used up
+  */
+  bool pickBest(PackedMove& move);
+
+  /*!
+    \brief Returns whether a move was already handed out as the hash move
+    or a killer
+  */
+  bool isSpecial(PackedMove move) const;
+
+  /*!
+    \brief Returns whether a tactical move loses material
+
+    The exchange is worked out for every promotion and for every capture
+    by an attacker that outranks what it captures; a capture of a piece
+    worth at least the attacker cannot lose.
+  */
+  bool isLosing(PackedMove move) const;
+
+  //! The position
+  const Board& m_board;
+
+  //! The scores of the quiet moves; null in a quiescence search
+  const MoveHistory* m_history;
+
+  //! The move to try first
+  PackedMove m_hashMove;
+
+  //! The killers of the ply
+  PackedMove m_killers[MoveHistory::NUM_KILLERS];
+
+  //! The current stage
+  Stage m_stage;
+
+  //! The moves of the current stage
+  MoveBuffer<> m_moves;
+
+  //! Score of each move in m_moves
+  int m_scores[MAX_MOVES];
+
+  //! Index of the next move of m_moves to hand out; the next killer in
+  //! STAGE_killers, the next of m_losing in STAGE_losing
+  int m_next;
+
+  //! Tactical moves put off because they lose material
+  MoveBuffer<> m_losing;
+};
+
+} // namespace sage
+
+#endif
@@ -0,0 +1,329 @@
+#ifndef INCLUDED_sage_PackedMove_h
+#define INCLUDED_sage_PackedMove_h
+
+#ifndef INCLUDED_sage_Move_h
+#include "sage/Move.h"
+#endif
+
+#ifndef INCLUDED_std_stdint
+#include <stdint.h>
+#define INCLUDED_std_stdint
+#endif
+
+#ifndef INCLUDED_std_vector
+#include <vector>
+#endif
+
+namespace sage {
+
+/*!
+  \brief A move packed into 16 bits
+
+  Bits 0-5 hold the start square, bits 6-11 the end square and bits 12-15
+  the move flags (see Flag). Squares are numbered as described for
+  Bitboard. The class has no virtual methods and only a single integer
+  member, so it can be copied with memcpy and stored compactly in move
+  lists and game records.
+
+  The moving piece is not stored; it is whatever stands on the start
+  square of the board the move is made on. Use ExtendedMove if the pieces
+  need to travel with the move.
+*/
+class PackedMove
+{
+ public:
+
+  //! Move flags, stored in the top four bits
+  enum Flag
+  {
+    FLAG_quiet                  = 0,  //!< Any other non-capture
+    FLAG_doublePush             = 1,  //!< Pawn moves ahead two squares
+    FLAG_kingCastle             = 2,  //!< Castles on the king side
+    FLAG_queenCastle            = 3,  //!< Castles on the queen side
+    FLAG_capture                = 4,  //!< Captures on the end square
+    FLAG_enPassant              = 5,  //!< Captures en passant
+    FLAG_knightPromotion        = 8,  //!< Promotes to a knight
+    FLAG_bishopPromotion        = 9,  //!< Promotes to a bishop
+    FLAG_rookPromotion          = 10, //!< Promotes to a rook
+    FLAG_queenPromotion         = 11, //!< Promotes to a queen
+    FLAG_knightPromotionCapture = 12, //!< Captures, promotes to a knight
+    FLAG_bishopPromotionCapture = 13, //!< Captures, promotes to a bishop
+    FLAG_rookPromotionCapture   = 14, //!< Captures, promotes to a rook
+    FLAG_queenPromotionCapture  = 15  //!< Captures, promotes to a queen
+  };
+
+  /*!
+    \brief Default constructor: leaves the move uninitialized
+
+    This keeps arrays of moves free to construct. Assign a value before
+    using it.
+  */
+  PackedMove()
+  {
+    ;
+  }
+
+  /*!
+    \brief Constructor
+    \param from The start square
+    \param to The end square
+    \param flags The move flags
+  */
+  PackedMove(int from, int to, Flag flags)
+    : m_data(static_cast<uint16_t>(from | (to << 6) | (flags << 12)))
+  {
+    ;
+  }
+
+  /*!
+    \brief Returns the start square
+  */
+  int getFrom() const { return m_data & 0x3f; }
+
+  /*!
+    \brief Returns the end square
+  */
+  int getTo() const { return (m_data >> 6) & 0x3f; }
+
+  /*!
+    \brief Returns the move flags
+  */
+  Flag getFlags() const { return static_cast<Flag>(m_data >> 12); }
+
+  /*!
+    \brief Returns whether this move captures a piece (including en
+    passant)
+  */
+  bool isCapture() const { return (m_data & 0x4000) != 0; }
+
+  /*!
+    \brief Returns whether this move promotes a pawn
+  */
+  bool isPromotion() const { return (m_data & 0x8000) != 0; }
+
+  /*!
+    \brief Returns whether this move captures or promotes; see
+    BoardUtil::MOVES_tactical
+  */
+  bool isTactical() const { return (m_data & 0xc000) != 0; }
+
+  /*!
+    \brief Returns whether this move is an en passant capture
+  */
+  bool isEnPassant() const { return getFlags() == FLAG_enPassant; }
+
+  /*!
+    \brief Returns whether this move castles
+  */
+  bool isCastle() const
+  {
+    return ((getFlags() == FLAG_kingCastle)
+            || (getFlags() == FLAG_queenCastle));
+  }
+
+  /*!
+    \brief Returns the piece a pawn promotes to
+    \param colorIndex Board::getColorIndex() of the moving side
+    \return The promotion piece type; PIECE_none if not a promotion
+  */
+  Piece::Type getPromotionType(int colorIndex) const
+  {
+    if (!isPromotion())
+    {
+      return Piece::PIECE_none;
+    }
+
+    // knight, bishop, rook, queen are 4, 3, 2, 1 places after the king
+    return Piece::getTypeFromIndex((colorIndex * 6) + 4 - (getFlags() & 3));
+  }
+
+  /*!
+    \brief Returns the raw 16 bit encoding
+  */
+  uint16_t getData() const { return m_data; }
+
+  /*!
+    \brief Equality operator
+  */
+  bool operator==(const PackedMove& other) const
+  {
+    return (m_data == other.m_data);
+  }
+
+  /*!
+    \brief Inequality operator
+  */
+  bool operator!=(const PackedMove& other) const { return !(*this == other); }
+
+  /*!
+    \brief Packs a Move
+    \param move The move to pack
+    \return The packed move
+  */
+  static PackedMove fromMove(const Move& move)
+  {
+    int from = move.getStartColumn() + (move.getStartRow() << 3);
+    int to = move.getEndColumn() + (move.getEndRow() << 3);
+    int type = move.getPiece().getType();
+    int flags = FLAG_quiet;
+
+    if (move.getPromotionType() != Piece::PIECE_none)
+    {
+      int offset = Piece::getIndex(move.getPromotionType()) % 6;
+      flags = (FLAG_knightPromotion + 4 - offset);
+      if (move.getCapture())
+      {
+        flags |= FLAG_capture;
+      }
+    }
+    else if (move.getEnPassant())
+    {
+      flags = FLAG_enPassant;
+    }
+    else if (move.getCapture())
+    {
+      flags = FLAG_capture;
+    }
+    else if ((type & Piece::PIECE_anyKing) && (move.getStartColumn() == 4)
+             && (move.getEndColumn() == 6))
+    {
+      flags = FLAG_kingCastle;
+    }
+    else if ((type & Piece::PIECE_anyKing) && (move.getStartColumn() == 4)
+             && (move.getEndColumn() == 2))
+    {
+      flags = FLAG_queenCastle;
+    }
+    else if ((type & Piece::PIECE_anyPawn)
+             && (((to - from) == 16) || ((from - to) == 16)))
+    {
+      flags = FLAG_doublePush;
+    }
+
+    return PackedMove(from, to, static_cast<Flag>(flags));
+  }
+
+  /*!
+    \brief Unpacks this move
+    \param movingType The type of the piece on the start square
+    \return The equivalent Move
+  */
+  Move toMove(Piece::Type movingType) const
+  {
+    Move move;
+    move.setPiece(Piece(getFrom() & 7, getFrom() >> 3, movingType));
+    move.setStartColumn(getFrom() & 7);
+    move.setStartRow(getFrom() >> 3);
+    move.setEndColumn(getTo() & 7);
+    move.setEndRow(getTo() >> 3);
+    move.setCapture(isCapture());
+    move.setEnPassant(isEnPassant());
+    move.setPromotionType(
+      getPromotionType((movingType & static_cast<int>(Piece::PIECE_whiteAll))
+                       ? 0 : 1));
+    return move;
+  }
+
+ private:
+  //! Start square, end square and flags
+  uint16_t m_data;
+};
+
+/*!
+  \brief A PackedMove together with the moving and captured pieces, in 32
+  bits
+
+  Bits 0-15 hold the PackedMove, bits 16-19 the Piece::getIndex() of the
+  moving piece and bits 20-23 the index of the captured piece (15 if
+  nothing is captured). Like PackedMove, it is trivially copyable. This
+  form can be unpacked without a board, which suits game records and
+  training data.
+*/
+class ExtendedMove
+{
+ public:
+
+  /*!
+    \brief Default constructor: leaves the move uninitialized
+  */
+  ExtendedMove()
+  {
+    ;
+  }
+
+  /*!
+    \brief Constructor
+    \param move The packed move
+    \param movingType The type of the moving piece
+    \param capturedType The type of the captured piece; PIECE_none if the
+    move is not a capture
+  */
+  ExtendedMove(PackedMove move,
+               Piece::Type movingType,
+               Piece::Type capturedType)
+    : m_data(move.getData()
+             | (static_cast<uint32_t>(Piece::getIndex(movingType)) << 16)
+             | (static_cast<uint32_t>(
+                  (capturedType == Piece::PIECE_none)
+                  ? NO_CAPTURE
+                  : Piece::getIndex(capturedType)) << 20))
+  {
+    ;
+  }
+
+  /*!
+    \brief Returns the packed move
+  */
+  PackedMove getMove() const
+  {
+    return PackedMove(m_data & 0x3f, (m_data >> 6) & 0x3f,
+                      static_cast<PackedMove::Flag>((m_data >> 12) & 0xf));
+  }
+
+  /*!
+    \brief Returns the type of the moving piece
+  */
+  Piece::Type getMovingType() const
+  {
+    return Piece::getTypeFromIndex((m_data >> 16) & 0xf);
+  }
+
+  /*!
+    \brief Returns the type of the captured piece; PIECE_none if none
+  */
+  Piece::Type getCapturedType() const
+  {
+    int index = (m_data >> 20) & 0xf;
+    return ((index == NO_CAPTURE)
+            ? Piece::PIECE_none
+            : Piece::getTypeFromIndex(index));
+  }
+
+  /*!
+    \brief Returns the raw 32 bit encoding
+  */
+  uint32_t getData() const { return m_data; }
+
+  /*!
+    \brief Unpacks this move
+    \return The equivalent Move
+  */
+  Move toMove() const { return getMove().toMove(getMovingType()); }
+
+ private:
+  //! Captured piece index used when nothing is captured
+  enum Constant
+  {
+    NO_CAPTURE = 0xf
+  };
+
+  //! Packed move, moving piece and captured piece
+  uint32_t m_data;
+};
+
+//! Handy typedef for a list of packed moves
+typedef std::vector<PackedMove> PackedMoveList;
+
+} // namespace sage
+
+#endif
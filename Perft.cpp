@@ -0,0 +1,282 @@
+#include "sage/Perft.h"
+
+#ifndef INCLUDED_sage_BoardUtil_h
+#include "sage/BoardUtil.h"
+#endif
+
+#ifndef INCLUDED_sage_MoveBuffer_h
+#include "sage/MoveBuffer.h"
+#endif
+
+#ifndef INCLUDED_sage_Timer_h
+#include "sage/Timer.h"
+#endif
+
+#ifndef INCLUDED_std_iostream
+#include <iostream>
+#define INCLUDED_std_iostream
+#endif
+
+#ifndef INCLUDED_std_memory
+#include <memory>
+#define INCLUDED_std_memory
+#endif
+
+namespace sage {
+
+namespace {
+
+  //! Standard perft positions and their published node counts
+  const Perft::Position SUITE[] =
+  {
+    { "start",
+      "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq -",
+      { 20ULL, 400ULL, 8902ULL, 197281ULL, 4865609ULL } },
+    { "kiwipete",
+      "r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w KQkq -",
+      { 48ULL, 2039ULL, 97862ULL, 4085603ULL, 193690690ULL } },
+    { "endgame",
+      "8/2p5/3p4/KP5r/1R3p1k/8/4P1P1/8 w - -",
+      { 14ULL, 191ULL, 2812ULL, 43238ULL, 674624ULL } },
+    { "promotions",
+      "r3k2r/Pppp1ppp/1b3nbN/nP6/BBP1P3/q4N2/Pp1P2PP/R2Q1RK1 w kq -",
+      { 6ULL, 264ULL, 9467ULL, 422333ULL, 15833292ULL } },
+    { "talkchess",
+      "rnbq1k1r/pp1Pbppp/2p5/8/2B5/8/PPP1NnPP/RNBQK2R w KQ -",
+      { 44ULL, 1486ULL, 62379ULL, 2103487ULL, 89941194ULL } },
+    { "middlegame",
+      "r4rk1/1pp1qppp/p1np1n2/2b1p1B1/2B1P1b1/P1NP1N2/1PP1QPPP/R4RK1 w - -",
+      { 46ULL, 2079ULL, 89890ULL, 3894594ULL, 164075551ULL } }
+  };
+
+  const int SUITE_SIZE = sizeof(SUITE) / sizeof(SUITE[0]);
+
+} // anonymous namespace
+
+uint64_t Perft::count(Board& board, int depth)
+{
+  if (depth <= 0)
+  {
+    return 1;
+  }
+
+  return countMoves(board, depth, 0);
+}
+
+uint64_t Perft::countMoves(Board& board, int depth, PerftTable* table)
+{
+  uint64_t nodes = 0;
+  if (table && (depth > 1) && table->probe(board.getHash(), depth, nodes))
+  {
+    return nodes;
+  }
+
+  // bulk counting: every legal move at the last ply is one leaf
+  if (depth == 1)
+  {
+    return BoardUtil::countLegalMoves(board);
+  }
+
+  MoveBuffer<> moveList;
+  BoardUtil::populateMoveList(board, moveList);
+
+  Board::Undo undo;
+
+  for (MoveBuffer<>::const_iterator iter = moveList.begin();
+       iter != moveList.end();
+       ++iter)
+  {
+    board.makeMove(*iter, undo);
+    nodes += countMoves(board, depth - 1, table);
+    board.unmakeMove(*iter, undo);
+  }
+
+  if (table)
+  {
+    table->store(board.getHash(), depth, nodes);
+  }
+
+  return nodes;
+}
+
+uint64_t Perft::count(const Board& board, int depth, ThreadPool& pool,
+                      PerftTable* table)
+{
+  if (depth <= 0)
+  {
+    return 1;
+  }
+
+  std::atomic<uint64_t> nodes(0);
+  ThreadPool::TaskGroup group;
+  countTask(board, depth, pool, group, table, nodes);
+  pool.wait(group);
+
+  return nodes.load();
+}
+
+uint64_t Perft::divide(const Board& board, int depth,
+                       DivideList& divideList, ThreadPool& pool,
+                       PerftTable* table)
+{
+  MoveBuffer<> moveList;
+  BoardUtil::populateMoveList(board, moveList);
+
+  std::unique_ptr<std::atomic<uint64_t>[]> counts(
+    new std::atomic<uint64_t>[moveList.size()]);
+  ThreadPool::TaskGroup group;
+
+  for (int i = 0; i < moveList.size(); ++i)
+  {
+    Board child(board);
+    Board::Undo undo;
+    child.makeMove(moveList[i], undo);
+
+    counts[i].store((depth <= 1) ? 1 : 0);
+    if (depth > 1)
+    {
+      std::atomic<uint64_t>& moveNodes = counts[i];
+      pool.submit(group, [=, &pool, &group, &moveNodes] {
+          countTask(child, depth - 1, pool, group, table, moveNodes);
+        });
+    }
+  }
+
+  pool.wait(group);
+
+  divideList.clear();
+  uint64_t nodes = 0;
+  for (int i = 0; i < moveList.size(); ++i)
+  {
+    divideList.push_back(std::make_pair(moveList[i], counts[i].load()));
+    nodes += counts[i].load();
+  }
+
+  return nodes;
+}
+
+void Perft::countTask(const Board& board, int depth, ThreadPool& pool,
+                      ThreadPool::TaskGroup& group, PerftTable* table,
+                      std::atomic<uint64_t>& nodes)
+{
+  Board copy(board);
+
+  if (depth <= SPLIT_DEPTH)
+  {
+    nodes += countMoves(copy, depth, table);
+    return;
+  }
+
+  // hand each child subtree to the pool; they add to the same total
+  MoveBuffer<> moveList;
+  BoardUtil::populateMoveList(copy, moveList);
+
+  for (MoveBuffer<>::const_iterator iter = moveList.begin();
+       iter != moveList.end();
+       ++iter)
+  {
+    Board child(copy);
+    Board::Undo undo;
+    child.makeMove(*iter, undo);
+
+    pool.submit(group, [=, &pool, &group, &nodes] {
+        countTask(child, depth - 1, pool, group, table, nodes);
+      });
+  }
+}
+
+uint64_t Perft::divide(Board& board, int depth, DivideList& divideList)
+{
+  MoveBuffer<> moveList;
+  BoardUtil::populateMoveList(board, moveList);
+
+  divideList.clear();
+  uint64_t nodes = 0;
+  Board::Undo undo;
+
+  for (MoveBuffer<>::const_iterator iter = moveList.begin();
+       iter != moveList.end();
+       ++iter)
+  {
+    board.makeMove(*iter, undo);
+    uint64_t moveNodes = count(board, depth - 1);
+    board.unmakeMove(*iter, undo);
+
+    divideList.push_back(std::make_pair(*iter, moveNodes));
+    nodes += moveNodes;
+  }
+
+  return nodes;
+}
+
+int Perft::getSuiteSize()
+{
+  return SUITE_SIZE;
+}
+
+const Perft::Position& Perft::getSuitePosition(int index)
+{
+  return SUITE[index];
+}
+
+bool Perft::runSuite(int maxDepth, std::ostream& out, ThreadPool* pool,
+                     PerftTable* table)
+{
+  if (maxDepth > MAX_SUITE_DEPTH)
+  {
+    maxDepth = MAX_SUITE_DEPTH;
+  }
+
+  bool passed = true;
+  uint64_t totalNodes = 0;
+  Timer totalTimer;
+
+  for (int i = 0; i < SUITE_SIZE; ++i)
+  {
+    Board board;
+    BoardUtil::setFen(board, SUITE[i].m_fen);
+
+    for (int depth = 1; depth <= maxDepth; ++depth)
+    {
+      Timer timer;
+      uint64_t nodes = (pool 
+                        ? count(board, depth, *pool, table)
+                        : countMoves(board, depth, table));
+      double seconds = timer.getElapsedSeconds();
+      uint64_t expected = SUITE[i].m_nodes[depth - 1];
+
+      out << SUITE[i].m_name << " depth " << depth
+          << " nodes " << nodes;
+      if (nodes == expected)
+      {
+        out << " ok";
+      }
+      else
+      {
+        out << " FAILED (expected " << expected << ")";
+        passed = false;
+      }
+      out << " time " << seconds << "s";
+      if (seconds > 0)
+      {
+        out << " nps " << static_cast<uint64_t>(nodes / seconds);
+      }
+      out << "\n";
+
+      totalNodes += nodes;
+    }
+  }
+
+  double seconds = totalTimer.getElapsedSeconds();
+  out << (passed ? "passed" : "FAILED")
+      << " nodes " << totalNodes << " time " << seconds << "s";
+  if (seconds > 0)
+  {
+    out << " nps " << static_cast<uint64_t>(totalNodes / seconds);
+  }
+  out << std::endl;
+
+  return passed;
+}
+
+} // namespace sage
@@ -0,0 +1,179 @@
+#ifndef INCLUDED_sage_Perft_h
+#define INCLUDED_sage_Perft_h
+
+#ifndef INCLUDED_sage_Board_h
+#include "sage/Board.h"
+#endif
+
+#ifndef INCLUDED_sage_PackedMove_h
+#include "sage/PackedMove.h"
+#endif
+
+#ifndef INCLUDED_sage_PerftTable_h
+#include "sage/PerftTable.h"
+#endif
+
+#ifndef INCLUDED_sage_ThreadPool_h
+#include "sage/ThreadPool.h"
+#endif
+
+#ifndef INCLUDED_std_atomic
+#include <atomic>
+#define INCLUDED_std_atomic
+#endif
+
+#ifndef INCLUDED_std_stdint
+#include <stdint.h>
+#define INCLUDED_std_stdint
+#endif
+
+#ifndef INCLUDED_std_iosfwd
+#include <iosfwd>
+#define INCLUDED_std_iosfwd
+#endif
+
+#ifndef INCLUDED_std_utility
+#include <utility>
+#define INCLUDED_std_utility
+#endif
+
+#ifndef INCLUDED_std_vector
+#include <vector>
+#endif
+
+namespace sage {
+
+/*!
+  \brief Move generator verification and benchmarking
+
+  Perft ("performance test") walks the tree of legal moves to a fixed depth
+  and counts the leaf nodes. The counts for many positions are well known,
+  so any difference points to a move generator or make/unmake bug, and the
+  time taken is a direct measure of move generation throughput.
+
+  Counting uses bulk counting: at the last ply the number of legal moves is
+  the number of leaves, so those moves are never made.
+
+  The parallel versions split the tree into tasks on a ThreadPool: one per
+  root move, and one per child move below any node with more than
+  SPLIT_DEPTH plies left. Below that each task counts its subtree on its
+  own board. An optional PerftTable shared by all threads memoizes the
+  counts of subtrees reached by more than one move order.
+
+  All methods are declared static so you don't have to instantiate this
+  class.
+*/
+class Perft
+{
+ public:
+
+  //! Node counts for each root move
+  typedef std::vector<std::pair<PackedMove, uint64_t> > DivideList;
+
+  //! Constants used by perft
+  enum Constant
+  {
+    MAX_SUITE_DEPTH = 5, //!< Deepest known count for each suite position
+    SPLIT_DEPTH = 5      //!< Subtrees at most this deep are not split
+  };
+
+  //! A position from the built-in suite with its known node counts
+  struct Position
+  {
+    const char* m_name;                //!< Short description
+    const char* m_fen;                 //!< The position
+    uint64_t m_nodes[MAX_SUITE_DEPTH]; //!< Leaf counts for depths 1 to 5
+  };
+
+  /*!
+    \brief Counts the leaf nodes of the move tree
+    \param board [inout] The root position; it is restored before returning
+    \param depth The depth in plies; 0 counts the root itself
+    \return The number of leaf nodes
+  */
+  static uint64_t count(Board& board, int depth);
+
+  /*!
+    \brief Counts the leaf nodes below each root move
+    \param board [inout] The root position; it is restored before returning
+    \param depth The depth in plies, including the root move; at least 1
+    \param divideList [out] One entry per legal root move
+    \return The total number of leaf nodes
+
+    Comparing this breakdown against a trusted engine narrows a wrong
+    count down to the root move whose subtree differs.
+  */
+  static uint64_t divide(Board& board, int depth, DivideList& divideList);
+
+  /*!
+    \brief Counts the leaf nodes of the move tree using a thread pool
+    \param board The root position
+    \param depth The depth in plies; 0 counts the root itself
+    \param pool The threads to count with
+    \param table Shared table of subtree counts; 0 for none
+    \return The number of leaf nodes
+  */
+  static uint64_t count(const Board& board, int depth, ThreadPool& pool,
+                        PerftTable* table);
+
+  /*!
+    \brief Counts the leaf nodes below each root move using a thread pool
+    \param board The root position
+    \param depth The depth in plies, including the root move; at least 1
+    \param divideList [out] One entry per legal root move
+    \param pool The threads to count with
+    \param table Shared table of subtree counts; 0 for none
+    \return The total number of leaf nodes
+  */
+  static uint64_t divide(const Board& board, int depth,
+                         DivideList& divideList, ThreadPool& pool,
+                         PerftTable* table);
+
+  /*!
+    \brief Returns the number of positions in the built-in suite
+  */
+  static int getSuiteSize();
+
+  /*!
+    \brief Returns a position from the built-in suite
+    \param index The position index [0, getSuiteSize() - 1]
+  */
+  static const Position& getSuitePosition(int index);
+
+  /*!
+    \brief Runs the built-in suite and reports the results
+    \param maxDepth Count every position to this depth [1, MAX_SUITE_DEPTH]
+    \param out Stream that receives one line per position and depth, with
+    the node count, the time taken and the nodes per second
+    \param pool The threads to count with; 0 to count on the calling thread
+    \param table Shared table of subtree counts; 0 for none
+    \retval true If every count matched
+    \retval false If any count was wrong
+  */
+  static bool runSuite(int maxDepth, std::ostream& out,
+                       ThreadPool* pool = 0, PerftTable* table = 0);
+
+ private:
+
+  /*!
+    \brief Recursive part of count(); depth is at least 1
+  */
+  static uint64_t countMoves(Board& board, int depth, PerftTable* table);
+
+  /*!
+    \brief Counts a subtree as a pool task, splitting it if it is deep
+    \param board The position at the top of the subtree
+    \param depth The depth of the subtree; at least 1
+    \param pool The pool the task runs on
+    \param group The group that child tasks join
+    \param table Shared table of subtree counts; 0 for none
+    \param nodes [inout] Receives the leaf count
+  */
+  static void countTask(const Board& board, int depth, ThreadPool& pool,
+                        ThreadPool::TaskGroup& group, PerftTable* table,
+                        std::atomic<uint64_t>& nodes);
+};
+
+} // namespace sage
+
+#endif
@@ -0,0 +1,161 @@
+#include "sage/Perft.h"
+#include "sage/PerftTable.h"
+#include "sage/ThreadPool.h"
+#include "sage/Board.h"
+#include "sage/BoardUtil.h"
+#include "sage/Exception.h"
+#include "sage/Timer.h"
+
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <memory>
+#include <string>
+
+namespace {
+
+  //! Depth used for the suite when none is given
+  const int DEFAULT_SUITE_DEPTH = 4;
+
+  void printUsage(const char* name)
+  {
+    std::cerr << "usage: " << name << " [options] suite [depth]\n"
+              << "       " << name << " [options] depth [fen]\n"
+              << "\n"
+              << "The first form checks the built-in positions up to the\n"
+              << "given depth (default " << DEFAULT_SUITE_DEPTH << ").\n"
+              << "The second prints the node count below each root move\n"
+              << "of the given position (default: the starting position).\n"
+              << "\n"
+              << "options:\n"
+              << "  -t threads  count in parallel; 0 uses every core\n"
+              << "  -H mb       share a hash table of this many megabytes;\n"
+              << "              implies -t 0 unless -t is given"
+              << std::endl;
+  }
+
+} // anonymous namespace
+
+int main(int argc, char** argv)
+{
+  int threads = -1;
+  int megabytes = 0;
+  int arg = 1;
+
+  for (; (arg + 1 < argc) && (argv[arg][0] == '-'); arg += 2)
+  {
+    if (!strcmp(argv[arg], "-t"))
+    {
+      threads = atoi(argv[arg + 1]);
+    }
+    else if (!strcmp(argv[arg], "-H"))
+    {
+      megabytes = atoi(argv[arg + 1]);
+    }
+    else
+    {
+      break;
+    }
+  }
+
+  if (arg >= argc)
+  {
+    printUsage(argv[0]);
+    return 2;
+  }
+
+  // the table is only used by the parallel counter
+  if ((megabytes > 0) && (threads < 0))
+  {
+    threads = 0;
+  }
+
+  std::unique_ptr<sage::ThreadPool> pool;
+  if (threads >= 0)
+  {
+    pool.reset(new sage::ThreadPool(threads));
+  }
+
+  std::unique_ptr<sage::PerftTable> table;
+  if (megabytes > 0)
+  {
+    table.reset(new sage::PerftTable(megabytes));
+  }
+
+  std::string command(argv[arg]);
+
+  try
+  {
+    if (command == "suite")
+    {
+      int depth = ((argc > arg + 1) 
+                   ? atoi(argv[arg + 1]) 
+                   : DEFAULT_SUITE_DEPTH);
+      return (sage::Perft::runSuite(depth, std::cout, pool.get(), 
+                                    table.get()) 
+              ? 0 : 1);
+    }
+
+    int depth = atoi(argv[arg]);
+    if (depth < 1)
+    {
+      printUsage(argv[0]);
+      return 2;
+    }
+
+    sage::Board board;
+    if (argc > arg + 1)
+    {
+      // the FEN fields may arrive as separate arguments
+      std::string fen;
+      for (int i = arg + 1; i < argc; ++i)
+      {
+        fen += argv[i];
+        fen += ' ';
+      }
+      sage::BoardUtil::setFen(board, fen);
+    }
+    else
+    {
+      sage::BoardUtil::initializeBoard(board);
+    }
+
+    sage::Timer timer;
+    sage::Perft::DivideList divideList;
+    uint64_t nodes = 0;
+    if (pool)
+    {
+      nodes = sage::Perft::divide(board, depth, divideList, *pool,
+                                  table.get());
+    }
+    else
+    {
+      nodes = sage::Perft::divide(board, depth, divideList);
+    }
+    double seconds = timer.getElapsedSeconds();
+
+    for (sage::Perft::DivideList::const_iterator iter = divideList.begin();
+         iter != divideList.end();
+         ++iter)
+    {
+      std::cout << sage::BoardUtil::getMoveString(iter->first) << ": "
+                << iter->second << "\n";
+    }
+
+    std::cout << "\nmoves " << divideList.size()
+              << " nodes " << nodes
+              << " time " << seconds << "s";
+    if (seconds > 0)
+    {
+      std::cout << " nps " << static_cast<uint64_t>(nodes / seconds);
+    }
+    std::cout << std::endl;
+  }
+  catch (const sage::Exception& e)
+  {
+    std::cerr << argv[0] << ": " << e.what() << std::endl;
+    return 2;
+  }
+
+  return 0;
+}
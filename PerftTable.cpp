@@ -0,0 +1,36 @@
+#include "sage/PerftTable.h"
+
+namespace sage {
+
+PerftTable::PerftTable(size_t megabytes)
+  : m_mask(0)
+{
+  size_t entries = (megabytes << 20) / sizeof(Entry);
+  size_t size = 1;
+  while ((size << 1) <= entries)
+  {
+    size <<= 1;
+  }
+
+  m_entries.reset(new Entry[size]);
+  m_mask = size - 1;
+  clear();
+}
+
+PerftTable::~PerftTable()
+{
+
+}
+
+void PerftTable::clear()
+{
+  // an all zero entry only matches a zero hash at depth zero, which is
+  // never probed
+  for (uint64_t i = 0; i <= m_mask; ++i)
+  {
+    m_entries[i].m_check.store(0, std::memory_order_relaxed);
+    m_entries[i].m_data.store(0, std::memory_order_relaxed);
+  }
+}
+
+} // namespace sage
@@ -0,0 +1,141 @@
+#ifndef INCLUDED_sage_PerftTable_h
+#define INCLUDED_sage_PerftTable_h
+
+#ifndef INCLUDED_sage_Zobrist_h
+#include "sage/Zobrist.h"
+#endif
+
+#ifndef INCLUDED_std_atomic
+#include <atomic>
+#define INCLUDED_std_atomic
+#endif
+
+#ifndef INCLUDED_std_cstddef
+#include <cstddef>
+#define INCLUDED_std_cstddef
+#endif
+
+#ifndef INCLUDED_std_memory
+#include <memory>
+#define INCLUDED_std_memory
+#endif
+
+namespace sage {
+
+/*!
+  \brief Hash table of perft subtree counts shared by many threads
+
+  Each entry maps a position hash and depth to the number of leaf nodes
+  below it. Different move orders reach the same positions, so deep perft
+  runs revisit many subtrees.
+
+  The table takes no locks. Every entry is two 64 bit words: the data
+  (count and depth) and the hash XORed with the data. Two threads writing
+  the same entry at once can leave the words from different stores, but
+  then the XOR no longer gives the hash back, so probe() rejects the entry
+  instead of returning a wrong count. New entries always replace old ones.
+*/
+class PerftTable
+{
+ public:
+
+  /*!
+    \brief Constructor: allocates an empty table
+    \param megabytes Approximate size of the table; rounded down to a power
+    of two number of entries, with at least one entry
+  */
+  explicit PerftTable(size_t megabytes);
+
+  /*!
+    \brief Destructor
+  */
+  virtual ~PerftTable();
+
+  /*!
+    \brief Looks up a subtree count
+    \param hash Board::getHash() of the position
+    \param depth The remaining depth [1, 255]
+    \param nodes [out] The stored count, if found
+    \retval true If the count was found
+    \retval false If it was not
+  */
+  bool probe(HashKey hash, int depth, uint64_t& nodes) const
+  {
+    const Entry& entry = m_entries[getIndex(hash, depth)];
+    uint64_t data = entry.m_data.load(std::memory_order_relaxed);
+    uint64_t check = entry.m_check.load(std::memory_order_relaxed);
+
+    if (((check ^ data) != hash)
+        || (static_cast<int>(data & DEPTH_MASK) != depth))
+    {
+      return false;
+    }
+
+    nodes = (data >> DEPTH_BITS);
+    return true;
+  }
+
+  /*!
+    \brief Stores a subtree count
+    \param hash Board::getHash() of the position
+    \param depth The remaining depth [1, 255]
+    \param nodes The number of leaf nodes; less than 2^56
+  */
+  void store(HashKey hash, int depth, uint64_t nodes)
+  {
+    Entry& entry = m_entries[getIndex(hash, depth)];
+    uint64_t data = ((nodes << DEPTH_BITS) | static_cast<uint64_t>(depth));
+    entry.m_data.store(data, std::memory_order_relaxed);
+    entry.m_check.store(hash ^ data, std::memory_order_relaxed);
+  }
+
+  /*!
+    \brief Empties the table
+
+    This must not be called while other threads use the table.
+  */
+  void clear();
+
+  /*!
+    \brief Returns the number of entries
+  */
+  size_t getSize() const { return (m_mask + 1); }
+
+ private:
+
+  //! Layout of the data word
+  enum Constant
+  {
+    DEPTH_BITS = 8,   //!< Low bits of the data word hold the depth
+    DEPTH_MASK = 0xff //!< Mask of the depth
+  };
+
+  //! One table slot
+  struct Entry
+  {
+    std::atomic<uint64_t> m_check; //!< Hash XOR data
+    std::atomic<uint64_t> m_data;  //!< Count and depth
+  };
+
+  /*!
+    \brief Returns the slot for a position and depth
+
+    The depth is mixed in so the counts for one position at different
+    depths do not all compete for one slot.
+  */
+  size_t getIndex(HashKey hash, int depth) const
+  {
+    return static_cast<size_t>((hash ^ (depth * 0x9e3779b97f4a7c15ULL))
+                               & m_mask);
+  }
+
+  //! The entries
+  std::unique_ptr<Entry[]> m_entries;
+
+  //! Number of entries minus one
+  uint64_t m_mask;
+};
+
+} // namespace sage
+
+#endif
@@ -1,6 +1,11 @@
 #ifndef INCLUDED_sage_Piece_h
 #define INCLUDED_sage_Piece_h
 
+#ifndef INCLUDED_std_cassert
+#include <cassert>
+#define INCLUDED_std_cassert
+#endif
+
 #ifndef INCLUDED_std_vector
 #include <vector>
 #endif
@@ -10,7 +15,7 @@ namespace sage {
 class Piece
 {
   public:
-//! Enumeration of chess pieces
+  //! Enumeration of chess pieces
   enum Type
   {
     PIECE_none        = 0x0000,
@@ -28,7 +33,7 @@ class Piece
     PIECE_blackPawn   = 0x2000
   };
 
-//! Masks to be used in conjunction with Piece
+  //! Masks to be used in conjunction with Piece
   enum Mask
   {
     PIECE_whiteAll  = (PIECE_whiteKing
@@ -51,6 +56,40 @@ class Piece
     PIECE_anyPawn   = (PIECE_whitePawn | PIECE_blackPawn)
   };
 
+  //! Constants related to piece types
+  enum Constant
+  {
+    NUM_TYPES = 12 //!< Number of piece types, not counting PIECE_none
+  };
+
+  /*!
+    \brief Returns a dense index for the given piece type
+    \param type The piece type; must not be PIECE_none
+    \return Index in the range [0, NUM_TYPES - 1]
+
+    White pieces map to [0, 5] and black pieces to [6, 11], in the same
+    order as the Type enumeration (king, queen, rook, bishop, knight, pawn).
+    PIECE_none has no index; the bit scan is undefined for it.
+  */
+  static int getIndex(Type type)
+  {
+    assert(type != PIECE_none);
+    int bit = __builtin_ctz(static_cast<unsigned int>(type));
+    return ((bit < 8) ? bit : (bit - 2));
+  }
+
+  /*!
+    \brief Returns the piece type for the given dense index
+    \param index Index in the range [0, NUM_TYPES - 1]
+    \return The piece type
+
+    This is the inverse of getIndex().
+  */
+  static Type getTypeFromIndex(int index)
+  {
+    return static_cast<Type>(1 << ((index < 6) ? index : (index + 2)));
+  }
+
   /*!
     \brief Constructor
    */
@@ -0,0 +1,125 @@
+#ifndef INCLUDED_sage_PolicyFactory_h
+#define INCLUDED_sage_PolicyFactory_h
+
+#ifndef INCLUDED_sage_Policy_h
+#include "sage/Policy.h"
+#endif
+
+#ifndef INCLUDED_std_stdint
+#include <stdint.h>
+#define INCLUDED_std_stdint
+#endif
+
+#ifndef INCLUDED_std_memory
+#include <memory>
+#define INCLUDED_std_memory
+#endif
+
+namespace sage {
+
+/*!
+  \brief Interface class for creating decision policies
+
+  Policies keep state between moves (random number generators, search
+  tables, ...), so each game needs its own. A Tournament asks the factory
+  for a fresh policy for every game it plays, from many threads at once,
+  so create() must be safe to call concurrently.
+
+  The seed passed to create() is derived from the tournament's master
+  seed, so a policy that draws all its randomness from it plays the same
+  moves every time the tournament is repeated.
+*/
+class PolicyFactory
+{
+ public:
+
+  /*!
+    \brief Default constructor
+  */
+  PolicyFactory()
+  {
+    ;
+  }
+
+  /*!
+    \brief Destructor
+  */
+  virtual ~PolicyFactory()
+  {
+    ;
+  }
+
+  /*!
+    \brief Creates a new policy
+    \param seed Seed for any randomness in the policy
+    \return The policy, owned by the caller
+  */
+  virtual std::unique_ptr<Policy> create(uint64_t seed) const = 0;
+
+ private:
+};
+
+/*!
+  \brief Factory for a deterministic policy class with a default
+  constructor; the seed is ignored
+*/
+template <class T>
+class DefaultPolicyFactory : public PolicyFactory
+{
+ public:
+
+  /*!
+    \brief Default constructor
+  */
+  DefaultPolicyFactory()
+  {
+    ;
+  }
+
+  /*!
+    \brief Destructor
+  */
+  virtual ~DefaultPolicyFactory()
+  {
+    ;
+  }
+
+  virtual std::unique_ptr<Policy> create(uint64_t seed) const
+  {
+    return std::unique_ptr<Policy>(new T());
+  }
+};
+
+/*!
+  \brief Factory for a policy class constructed from a seed
+*/
+template <class T>
+class SeededPolicyFactory : public PolicyFactory
+{
+ public:
+
+  /*!
+    \brief Default constructor
+  */
+  SeededPolicyFactory()
+  {
+    ;
+  }
+
+  /*!
+    \brief Destructor
+  */
+  virtual ~SeededPolicyFactory()
+  {
+    ;
+  }
+
+  virtual std::unique_ptr<Policy> create(uint64_t seed) const
+  {
+    return std::unique_ptr<Policy>(new T(seed));
+  }
+};
+
+} // namespace sage
+
+#endif
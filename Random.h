@@ -0,0 +1,134 @@
+#ifndef INCLUDED_sage_Random_h
+#define INCLUDED_sage_Random_h
+
+#ifndef INCLUDED_std_stdint
+#include <stdint.h>
+#define INCLUDED_std_stdint
+#endif
+
+namespace sage {
+
+/*!
+  \brief Fast, seedable pseudo-random number generator
+
+  This is xoshiro256**: 256 bits of state, a period of 2^256 - 1 and a
+  handful of shifts, rotates and multiplies per number. Each instance has
+  its own state, so policies on different threads never share or race on
+  a generator, and the same seed always gives the same numbers.
+
+  The state is filled from the seed with SplitMix64, which also mixes
+  master seeds into independent per-game seeds (see deriveSeed()).
+*/
+class Random
+{
+ public:
+
+  /*!
+    \brief Constructor: seeds the generator
+    \param seed Any value; equal seeds give equal sequences
+  */
+  explicit Random(uint64_t seed)
+  {
+    setSeed(seed);
+  }
+
+  /*!
+    \brief Destructor
+  */
+  virtual ~Random()
+  {
+    ;
+  }
+
+  /*!
+    \brief Restarts the generator from a seed
+    \param seed Any value; equal seeds give equal sequences
+  */
+  void setSeed(uint64_t seed)
+  {
+    for (int i = 0; i < 4; ++i)
+    {
+      seed += 0x9e3779b97f4a7c15ULL;
+      m_state[i] = mix(seed);
+    }
+  }
+
+  /*!
+    \brief Returns the next 64 random bits
+  */
+  uint64_t next()
+  {
+    uint64_t result = rotate(m_state[1] * 5, 7) * 9;
+    uint64_t t = (m_state[1] << 17);
+
+    m_state[2] ^= m_state[0];
+    m_state[3] ^= m_state[1];
+    m_state[1] ^= m_state[2];
+    m_state[0] ^= m_state[3];
+    m_state[2] ^= t;
+    m_state[3] = rotate(m_state[3], 45);
+
+    return result;
+  }
+
+  /*!
+    \brief Returns a random integer in [0, bound)
+    \param bound The number of possible values; at least 1
+
+    The top 32 bits are scaled into range with a multiply instead of a
+    division. The bias this leaves is below 2^-32 * bound.
+  */
+  int nextInt(int bound)
+  {
+    return static_cast<int>(((next() >> 32) * static_cast<uint64_t>(bound))
+                            >> 32);
+  }
+
+  /*!
+    \brief Returns a random number in [0.0, 1.0)
+  */
+  double nextDouble()
+  {
+    return (next() >> 11) * (1.0 / 9007199254740992.0);
+  }
+
+  /*!
+    \brief Derives an independent seed from a master seed
+    \param master The master seed, e.g. of a whole tournament
+    \param index Which derived seed, e.g. the game number
+    \return The seed; different indices give unrelated seeds
+  */
+  static uint64_t deriveSeed(uint64_t master, uint64_t index)
+  {
+    return mix(mix(master) + (index + 1) * 0x9e3779b97f4a7c15ULL);
+  }
+
+ private:
+  // Default constructor not defined
+  Random();
+
+  /*!
+    \brief The SplitMix64 finalizer
+  */
+  static uint64_t mix(uint64_t z)
+  {
+    z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+    z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+    return z ^ (z >> 31);
+  }
+
+  /*!
+    \brief Rotates the bits of x left by k [1, 63]
+  */
+  static uint64_t rotate(uint64_t x, int k)
+  {
+    return (x << k) | (x >> (64 - k));
+  }
+
+  //! Generator state; never all zero
+  uint64_t m_state[4];
+};
+
+} // namespace sage
+
+#endif
@@ -5,9 +5,8 @@
 #include "sage/Policy.h"
 #endif
 
-#ifndef INCLUDED_std_ctime
-#include <ctime>
-#define INCLUDED_std_ctime
+#ifndef INCLUDED_sage_Random_h
+#include "sage/Random.h"
 #endif
 
 namespace sage {
@@ -15,19 +14,23 @@ namespace sage {
 /*!
   \brief Chess policy that randomly chooses among moves.
 
-  This class initializes the rand48 number generator upon construction
-  and them uses a different random move from movelist each time.
+  Each policy has its own random number generator, seeded on
+  construction, and uses a different random move from movelist each time.
+  Policies built with the same seed choose the same moves, and policies
+  on different threads do not interfere.
 */
 class RandomPolicy : public Policy
 {
  public:
 
   /*!
-    \brief Default constructor
+    \brief Constructor
+    \param seed Seed for the random number generator
   */
-  RandomPolicy()
+  explicit RandomPolicy(uint64_t seed)
+    : m_random(seed)
   {
-    srand48(time(0));
+    ;
   }
 
   /*!
@@ -40,10 +43,13 @@ class RandomPolicy : public Policy
 
   virtual int decide(const Board& board, const MoveList& moveList)
   {
-    return static_cast<int>(drand48() * moveList.size());
+    return m_random.nextInt(static_cast<int>(moveList.size()));
   }
 
  private:
+
+  //! Chooses the moves
+  Random m_random;
 };
 
 } // namespace sage
@@ -10,4 +10,19 @@ enum State
   STATE_draw
 };
 
+//! Enumeration of the ways a game can end
+enum Reason
+{
+  REASON_none,                  //!< The game is still going on
+  REASON_checkmate,             //!< The side to move is mated
+  REASON_stalemate,             //!< The side to move has no legal move
+  REASON_insufficientMaterial,  //!< Neither side can mate
+  REASON_repetition,            //!< The position occurred three times
+  REASON_fiftyMove,             //!< Fifty moves without capture or pawn move
+  REASON_resignation,           //!< The score stayed lost for too long
+  REASON_drawAdjudication,      //!< The score stayed level for too long
+  REASON_maxPlies,              //!< The game reached its ply limit
+  REASON_external               //!< Set from outside without a reason
+};
+
 #endif
@@ -0,0 +1,285 @@
+#ifndef INCLUDED_sage_Task_h
+#define INCLUDED_sage_Task_h
+
+#ifndef INCLUDED_sage_Exception_h
+#include "sage/Exception.h"
+#endif
+
+#ifndef INCLUDED_std_coroutine
+#include <coroutine>
+#define INCLUDED_std_coroutine
+#endif
+
+#ifndef INCLUDED_std_exception
+#include <exception>
+#define INCLUDED_std_exception
+#endif
+
+#ifndef INCLUDED_std_utility
+#include <utility>
+#define INCLUDED_std_utility
+#endif
+
+namespace sage {
+
+template <class T> class Task;
+
+/*!
+  \brief Promise parts shared by every Task
+
+  A task starts suspended and runs when it is first awaited or resumed.
+  When it finishes it resumes whoever awaited it, directly from its final
+  suspend point, so chains of awaiting tasks neither grow the stack nor go
+  back through a scheduler. A task that nobody awaits returns control to
+  whoever resumed it.
+*/
+class TaskPromiseBase
+{
+ public:
+
+  //! Resumes the awaiting coroutine once the task has finished
+  struct FinalAwaiter
+  {
+    bool await_ready() const noexcept { return false; }
+
+    template <class Promise>
+    std::coroutine_handle<>
+    await_suspend(std::coroutine_handle<Promise> handle) const noexcept
+    {
+      std::coroutine_handle<> continuation =
+        handle.promise().m_continuation;
+      return (continuation ? continuation : std::noop_coroutine());
+    }
+
+    void await_resume() const noexcept
+    {
+      ;
+    }
+  };
+
+  /*!
+    \brief Default constructor
+  */
+  TaskPromiseBase()
+    : m_continuation(), m_exception()
+  {
+    ;
+  }
+
+  std::suspend_always initial_suspend() const noexcept { return {}; }
+
+  FinalAwaiter final_suspend() const noexcept { return {}; }
+
+  void unhandled_exception() { m_exception = std::current_exception(); }
+
+  //! The coroutine awaiting this task; empty if none
+  std::coroutine_handle<> m_continuation;
+
+  //! Exception thrown by the task, rethrown to whoever gets the result
+  std::exception_ptr m_exception;
+};
+
+/*!
+  \brief Promise of a Task that produces a value
+*/
+template <class T>
+class TaskPromise : public TaskPromiseBase
+{
+ public:
+
+  Task<T> get_return_object();
+
+  void return_value(T value) { m_value = std::move(value); }
+
+  /*!
+    \brief Returns the value, or rethrows what the task threw
+  */
+  T& getResult()
+  {
+    if (m_exception)
+    {
+      std::rethrow_exception(m_exception);
+    }
+    return m_value;
+  }
+
+ private:
+
+  //! The value the task returned
+  T m_value;
+};
+
+/*!
+  \brief Promise of a Task that produces no value
+*/
+template <>
+class TaskPromise<void> : public TaskPromiseBase
+{
+ public:
+
+  Task<void> get_return_object();
+
+  void return_void() const
+  {
+    ;
+  }
+
+  /*!
+    \brief Rethrows what the task threw, if anything
+  */
+  void getResult()
+  {
+    if (m_exception)
+    {
+      std::rethrow_exception(m_exception);
+    }
+  }
+};
+
+/*!
+  \brief A lazily started coroutine that can be awaited
+
+  A coroutine returning Task<T> runs when another coroutine co_awaits it,
+  and the co_await evaluates to the value it co_returns (or rethrows what
+  it threw). A top level task, such as a whole game, is instead started
+  with resume() by a scheduler, which checks isDone() after each resume.
+
+  The Task owns the coroutine frame and destroys it in its destructor.
+  Arguments a coroutine takes by reference must outlive it.
+*/
+template <class T>
+class Task
+{
+ public:
+
+  //! The promise type the compiler looks up
+  typedef TaskPromise<T> promise_type;
+
+  //! Handle to the coroutine frame
+  typedef std::coroutine_handle<promise_type> Handle;
+
+  /*!
+    \brief Default constructor: builds a task without a coroutine
+  */
+  Task()
+    : m_handle()
+  {
+    ;
+  }
+
+  /*!
+    \brief Constructor: takes ownership of a coroutine
+  */
+  explicit Task(Handle handle)
+    : m_handle(handle)
+  {
+    ;
+  }
+
+  /*!
+    \brief Move constructor
+  */
+  Task(Task&& other) noexcept
+    : m_handle(std::exchange(other.m_handle, Handle()))
+  {
+    ;
+  }
+
+  /*!
+    \brief Move assignment
+  */
+  Task& operator=(Task&& other) noexcept
+  {
+    if (this != &other)
+    {
+      destroy();
+      m_handle = std::exchange(other.m_handle, Handle());
+    }
+    return *this;
+  }
+
+  /*!
+    \brief Destructor: destroys the coroutine, finished or not
+  */
+  virtual ~Task()
+  {
+    destroy();
+  }
+
+  /*!
+    \brief Returns whether the coroutine has run to completion; true for
+    a task without a coroutine
+  */
+  bool isDone() const { return (!m_handle || m_handle.done()); }
+
+  /*!
+    \brief Runs the coroutine until it next suspends
+  */
+  void resume() { m_handle.resume(); }
+
+  /*!
+    \brief Returns the handle, e.g. to queue the task on a scheduler
+  */
+  std::coroutine_handle<> getHandle() const { return m_handle; }
+
+  /*!
+    \brief Returns the result of a finished task
+    \return The value it returned; rethrows what it threw
+
+    Throws Exception if the task has no coroutine (e.g. it was default
+    constructed or moved from); awaiting such a task throws the same.
+  */
+  decltype(auto) getResult()
+  {
+    if (!m_handle)
+    {
+      throw Exception("Task: no coroutine to get the result of");
+    }
+    return m_handle.promise().getResult();
+  }
+
+  bool await_ready() const noexcept { return isDone(); }
+
+  std::coroutine_handle<> await_suspend(std::coroutine_handle<> awaiting)
+  {
+    m_handle.promise().m_continuation = awaiting;
+    return m_handle;
+  }
+
+  decltype(auto) await_resume() { return getResult(); }
+
+ private:
+  // Copying not allowed
+  Task(const Task&);
+  Task& operator=(const Task&);
+
+  /*!
+    \brief Destroys the coroutine frame, if any
+  */
+  void destroy()
+  {
+    if (m_handle)
+    {
+      m_handle.destroy();
+      m_handle = Handle();
+    }
+  }
+
+  //! The coroutine frame
+  Handle m_handle;
+};
+
+template <class T>
+inline Task<T> TaskPromise<T>::get_return_object()
+{
+  return Task<T>(Task<T>::Handle::from_promise(*this));
+}
+
+inline Task<void> TaskPromise<void>::get_return_object()
+{
+  return Task<void>(Task<void>::Handle::from_promise(*this));
+}
+
+} // namespace sage
+
+#endif
@@ -0,0 +1,103 @@
+#include "sage/TextEventSink.h"
+
+#ifndef INCLUDED_sage_BoardUtil_h
+#include "sage/BoardUtil.h"
+#endif
+
+#ifndef INCLUDED_sage_PackedMove_h
+#include "sage/PackedMove.h"
+#endif
+
+#ifndef INCLUDED_sage_State_h
+#include "sage/State.h"
+#endif
+
+#ifndef INCLUDED_std_ostream
+#include <ostream>
+#define INCLUDED_std_ostream
+#endif
+
+namespace sage {
+
+namespace {
+
+  //! Text for each State
+  const char* const STATE_NAMES[] =
+  {
+    "*", "1-0", "0-1", "1/2-1/2"
+  };
+
+  //! Text for each Reason
+  const char* const REASON_NAMES[] =
+  {
+    "none", "checkmate", "stalemate", "material", "repetition",
+    "fifty-move", "resignation", "adjudicated", "max-plies", "external"
+  };
+
+} // anonymous namespace
+
+TextEventSink::TextEventSink(std::ostream& out)
+  : m_out(out), m_mutex()
+{
+
+}
+
+TextEventSink::~TextEventSink()
+{
+
+}
+
+void TextEventSink::record(const GameEvent& event)
+{
+  std::string text;
+  format(event, text);
+
+  std::lock_guard<std::mutex> lock(m_mutex);
+  m_out << text;
+  m_out.flush();
+}
+
+void TextEventSink::flush()
+{
+  std::lock_guard<std::mutex> lock(m_mutex);
+  m_out.flush();
+}
+
+void TextEventSink::format(const GameEvent& event, std::string& text)
+{
+  text += "game ";
+  text += std::to_string(event.m_game);
+
+  switch (event.m_type)
+  {
+  case GameEvent::TYPE_start:
+    text += " start";
+    break;
+  case GameEvent::TYPE_move:
+    {
+      PackedMove move(event.m_move & 0x3f, (event.m_move >> 6) & 0x3f,
+                      static_cast<PackedMove::Flag>(event.m_move >> 12));
+      text += " ply ";
+      text += std::to_string(event.m_ply);
+      text += " move ";
+      text += std::to_string(event.m_choice);
+      text += ' ';
+      text += BoardUtil::getMoveString(move);
+    }
+    break;
+  default:
+    text += " end ply ";
+    text += std::to_string(event.m_ply);
+    text += " result ";
+    text += ((event.m_state <= STATE_draw)
+             ? STATE_NAMES[event.m_state] : "?");
+    text += ' ';
+    text += ((event.m_reason <= REASON_external)
+             ? REASON_NAMES[event.m_reason] : "?");
+    break;
+  }
+
+  text += '\n';
+}
+
+} // namespace sage
@@ -0,0 +1,82 @@
+#ifndef INCLUDED_sage_TextEventSink_h
+#define INCLUDED_sage_TextEventSink_h
+
+#ifndef INCLUDED_sage_GameEvent_h
+#include "sage/GameEvent.h"
+#endif
+
+#ifndef INCLUDED_std_iosfwd
+#include <iosfwd>
+#define INCLUDED_std_iosfwd
+#endif
+
+#ifndef INCLUDED_std_mutex
+#include <mutex>
+#define INCLUDED_std_mutex
+#endif
+
+#ifndef INCLUDED_std_string
+#include <string>
+#define INCLUDED_std_string
+#endif
+
+namespace sage {
+
+/*!
+  \brief Sink that writes each event as a line of text as it is recorded
+
+  The line is written and the stream flushed before record() returns, on
+  the recording thread, so the log stays in step with anything else
+  written to the stream from that thread. This is the sink for
+  interactive play, where a human policy prints the board and its prompts
+  to the same stream. For batch runs use AsyncTextEventSink, which keeps
+  the games from waiting on the stream.
+
+  The sink is thread-safe; lines from different threads are not mixed.
+
+  Lines look like this:
+
+    game 7 start
+    game 7 ply 0 move 12 e2e4
+    game 7 end ply 83 result 1-0 checkmate
+*/
+class TextEventSink : public GameEventSink
+{
+ public:
+
+  /*!
+    \brief Constructor
+    \param out The stream to write to; it must outlive the sink
+  */
+  explicit TextEventSink(std::ostream& out);
+
+  /*!
+    \brief Destructor
+  */
+  virtual ~TextEventSink();
+
+  virtual void record(const GameEvent& event);
+
+  virtual void flush();
+
+  /*!
+    \brief Appends the line describing an event, newline included
+    \param event The event
+    \param text [inout] The text to append to
+  */
+  static void format(const GameEvent& event, std::string& text);
+
+ private:
+  // Default constructor not defined
+  TextEventSink();
+
+  //! The stream to write to
+  std::ostream& m_out;
+
+  //! Guards the stream
+  std::mutex m_mutex;
+};
+
+} // namespace sage
+
+#endif
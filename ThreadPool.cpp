@@ -0,0 +1,164 @@
+#include "sage/ThreadPool.h"
+
+namespace sage {
+
+thread_local int ThreadPool::s_workerIndex = -1;
+thread_local ThreadPool* ThreadPool::s_workerPool = 0;
+
+ThreadPool::ThreadPool(int numThreads)
+  : m_queued(0),
+    m_nextQueue(0),
+    m_stop(false)
+{
+  if (numThreads <= 0)
+  {
+    numThreads = static_cast<int>(std::thread::hardware_concurrency());
+    if (numThreads <= 0)
+    {
+      numThreads = 1;
+    }
+  }
+
+  for (int i = 0; i < numThreads; ++i)
+  {
+    m_queues.push_back(std::unique_ptr<Queue>(new Queue));
+  }
+
+  for (int i = 0; i < numThreads; ++i)
+  {
+    m_threads.push_back(std::thread(&ThreadPool::workerLoop, this, i));
+  }
+}
+
+ThreadPool::~ThreadPool()
+{
+  {
+    std::lock_guard<std::mutex> lock(m_sleepMutex);
+    m_stop = true;
+  }
+  m_wake.notify_all();
+
+  for (size_t i = 0; i < m_threads.size(); ++i)
+  {
+    m_threads[i].join();
+  }
+}
+
+void ThreadPool::submit(TaskGroup& group, const Task& task)
+{
+  // workers keep their own tasks; outside threads deal them out in turn
+  int index = ((s_workerPool == this)
+               ? s_workerIndex
+               : static_cast<int>(m_nextQueue++ % m_queues.size()));
+
+  Job job;
+  job.m_task = task;
+  job.m_group = &group;
+
+  ++group.m_pending;
+  {
+    std::lock_guard<std::mutex> lock(m_queues[index]->m_mutex);
+    m_queues[index]->m_jobs.push_back(job);
+  }
+  ++m_queued;
+
+  // taking the lock orders this wakeup after any sleeper's last check
+  {
+    std::lock_guard<std::mutex> lock(m_sleepMutex);
+  }
+  m_wake.notify_one();
+}
+
+void ThreadPool::wait(TaskGroup& group)
+{
+  int index = ((s_workerPool == this) ? s_workerIndex : -1);
+
+  while (!group.isDone())
+  {
+    Job job;
+    if (popJob(index, job))
+    {
+      runJob(job);
+      continue;
+    }
+
+    // the remaining tasks are running on other threads
+    std::unique_lock<std::mutex> lock(m_sleepMutex);
+    m_wake.wait(lock, [&] {
+        return (group.isDone() || (m_queued.load() > 0));
+      });
+  }
+}
+
+void ThreadPool::workerLoop(int index)
+{
+  s_workerIndex = index;
+  s_workerPool = this;
+
+  for (;;)
+  {
+    Job job;
+    if (popJob(index, job))
+    {
+      runJob(job);
+      continue;
+    }
+
+    std::unique_lock<std::mutex> lock(m_sleepMutex);
+    m_wake.wait(lock, [this] {
+        return (m_stop || (m_queued.load() > 0));
+      });
+
+    if (m_stop && (m_queued.load() == 0))
+    {
+      return;
+    }
+  }
+}
+
+bool ThreadPool::popJob(int index, Job& job)
+{
+  if (index >= 0)
+  {
+    Queue& queue = *m_queues[index];
+    std::lock_guard<std::mutex> lock(queue.m_mutex);
+    if (!queue.m_jobs.empty())
+    {
+      job = queue.m_jobs.back();
+      queue.m_jobs.pop_back();
+      --m_queued;
+      return true;
+    }
+  }
+
+  // steal the oldest job from someone else
+  int numQueues = static_cast<int>(m_queues.size());
+  for (int i = 1; i <= numQueues; ++i)
+  {
+    Queue& queue = *m_queues[(index + i + numQueues) % numQueues];
+    std::lock_guard<std::mutex> lock(queue.m_mutex);
+    if (!queue.m_jobs.empty())
+    {
+      job = queue.m_jobs.front();
+      queue.m_jobs.pop_front();
+      --m_queued;
+      return true;
+    }
+  }
+
+  return false;
+}
+
+void ThreadPool::runJob(Job& job)
+{
+  job.m_task();
+
+  // the group may be destroyed as soon as its count reaches zero
+  if (--job.m_group->m_pending == 0)
+  {
+    std::lock_guard<std::mutex> lock(m_sleepMutex);
+    m_wake.notify_all();
+  }
+}
+
+} // namespace sage
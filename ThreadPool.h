@@ -0,0 +1,201 @@
+#ifndef INCLUDED_sage_ThreadPool_h
+#define INCLUDED_sage_ThreadPool_h
+
+#ifndef INCLUDED_std_atomic
+#include <atomic>
+#define INCLUDED_std_atomic
+#endif
+
+#ifndef INCLUDED_std_condition_variable
+#include <condition_variable>
+#define INCLUDED_std_condition_variable
+#endif
+
+#ifndef INCLUDED_std_deque
+#include <deque>
+#define INCLUDED_std_deque
+#endif
+
+#ifndef INCLUDED_std_functional
+#include <functional>
+#define INCLUDED_std_functional
+#endif
+
+#ifndef INCLUDED_std_memory
+#include <memory>
+#define INCLUDED_std_memory
+#endif
+
+#ifndef INCLUDED_std_mutex
+#include <mutex>
+#define INCLUDED_std_mutex
+#endif
+
+#ifndef INCLUDED_std_thread
+#include <thread>
+#define INCLUDED_std_thread
+#endif
+
+#ifndef INCLUDED_std_vector
+#include <vector>
+#endif
+
+namespace sage {
+
+/*!
+  \brief Fixed set of worker threads that run submitted tasks
+
+  Each worker has its own task queue. A task submitted from inside a
+  worker goes onto that worker's queue, and the worker takes its newest
+  task first, so recursive work stays on one thread while it is hot in the
+  cache. An idle worker steals the oldest task from another queue, which
+  tends to be the largest piece of remaining work. Tasks submitted from
+  outside the pool are dealt out over the queues in turn.
+
+  Tasks are tracked with a TaskGroup. wait() blocks until every task in the
+  group has finished, including tasks those tasks submitted to the same
+  group, and runs queued tasks itself while it waits.
+*/
+class ThreadPool
+{
+ public:
+
+  //! A unit of work
+  typedef std::function<void()> Task;
+
+  /*!
+    \brief Counts the unfinished tasks submitted as a group
+  */
+  class TaskGroup
+  {
+   public:
+    /*!
+      \brief Default constructor: builds an empty group
+    */
+    TaskGroup()
+      : m_pending(0)
+    {
+      ;
+    }
+
+    /*!
+      \brief Returns whether every task in the group has finished
+    */
+    bool isDone() const { return (m_pending.load() == 0); }
+
+   private:
+    friend class ThreadPool;
+
+    //! Number of submitted tasks that have not finished
+    std::atomic<int> m_pending;
+  };
+
+  /*!
+    \brief Constructor: starts the worker threads
+    \param numThreads Number of workers; 0 uses one per hardware thread
+  */
+  explicit ThreadPool(int numThreads = 0);
+
+  /*!
+    \brief Destructor: finishes queued tasks and stops the workers
+  */
+  virtual ~ThreadPool();
+
+  /*!
+    \brief Returns the number of worker threads
+  */
+  int getNumThreads() const { return static_cast<int>(m_threads.size()); }
+
+  /*!
+    \brief Queues a task to run on the pool
+    \param group The group the task belongs to; it must outlive the task
+    \param task The task to run; it must not throw
+
+    This may be called from any thread, including from inside a task.
+  */
+  void submit(TaskGroup& group, const Task& task);
+
+  /*!
+    \brief Waits until all tasks in the group have finished
+    \param group The group to wait for
+
+    The calling thread runs queued tasks while it waits, so it is safe to
+    call this from inside a task.
+  */
+  void wait(TaskGroup& group);
+
+  /*!
+    \brief Returns the index of the worker running the calling thread
+    \return The index in [0, getNumThreads() - 1]; -1 if the caller is not
+    a worker of any pool
+  */
+  static int getWorkerIndex() { return s_workerIndex; }
+
+ private:
+
+  //! A queued task and the group it counts against
+  struct Job
+  {
+    Task m_task;        //!< The work to do
+    TaskGroup* m_group; //!< Group to notify when done
+  };
+
+  //! One worker's queue of jobs
+  struct Queue
+  {
+    std::mutex m_mutex;       //!< Guards m_jobs
+    std::deque<Job> m_jobs;   //!< Newest at the back
+  };
+
+  /*!
+    \brief Main loop of each worker thread
+    \param index The worker's index
+  */
+  void workerLoop(int index);
+
+  /*!
+    \brief Takes a job, preferring the given queue
+    \param index The queue to take the newest job from first; -1 to
+    only steal
+    \param job [out] The job taken
+    \retval true If a job was taken
+    \retval false If every queue was empty
+  */
+  bool popJob(int index, Job& job);
+
+  /*!
+    \brief Runs a job and marks it finished in its group
+  */
+  void runJob(Job& job);
+
+  //! Job queues, indexed by worker
+  std::vector<std::unique_ptr<Queue> > m_queues;
+
+  //! The worker threads
+  std::vector<std::thread> m_threads;
+
+  //! Guards sleeping and waking; see m_wake
+  std::mutex m_sleepMutex;
+
+  //! Signalled when jobs are queued, groups finish or the pool stops
+  std::condition_variable m_wake;
+
+  //! Number of jobs sitting in queues
+  std::atomic<int> m_queued;
+
+  //! Queue that the next outside submission goes to
+  std::atomic<unsigned int> m_nextQueue;
+
+  //! Set when the pool is shutting down
+  bool m_stop;
+
+  //! Index of the worker running the current thread; -1 if none
+  static thread_local int s_workerIndex;
+
+  //! Pool that owns the current worker thread; 0 if none
+  static thread_local ThreadPool* s_workerPool;
+};
+
+} // namespace sage
+
+#endif
@@ -0,0 +1,63 @@
+#ifndef INCLUDED_sage_Timer_h
+#define INCLUDED_sage_Timer_h
+
+#ifndef INCLUDED_std_chrono
+#include <chrono>
+#define INCLUDED_std_chrono
+#endif
+
+namespace sage {
+
+/*!
+  \brief Measures wall clock time from when it was constructed or reset
+
+  This uses a monotonic clock, so it is not affected by changes to the
+  system time.
+*/
+class Timer
+{
+ public:
+
+  /*!
+    \brief Default constructor: starts timing now
+  */
+  Timer()
+    : m_start(Clock::now())
+  {
+    ;
+  }
+
+  /*!
+    \brief Restarts timing from now
+  */
+  void reset() { m_start = Clock::now(); }
+
+  /*!
+    \brief Returns the number of seconds since the timer was started
+  */
+  double getElapsedSeconds() const
+  {
+    return std::chrono::duration<double>(Clock::now() - m_start).count();
+  }
+
+  /*!
+    \brief Returns the number of milliseconds since the timer was started
+  */
+  long getElapsedMilliseconds() const
+  {
+    return static_cast<long>(
+      std::chrono::duration_cast<std::chrono::milliseconds>(
+        Clock::now() - m_start).count());
+  }
+
+ private:
+  //! Clock used for all measurements
+  typedef std::chrono::steady_clock Clock;
+
+  //! When timing started
+  Clock::time_point m_start;
+};
+
+} // namespace sage
+
+#endif
@@ -0,0 +1,176 @@
+#include "sage/Tournament.h"
+
+#ifndef INCLUDED_sage_BoardUtil_h
+#include "sage/BoardUtil.h"
+#endif
+
+#ifndef INCLUDED_sage_Random_h
+#include "sage/Random.h"
+#endif
+
+#ifndef INCLUDED_sage_Exception_h
+#include "sage/Exception.h"
+#endif
+
+#ifndef INCLUDED_std_algorithm
+#include <algorithm>
+#define INCLUDED_std_algorithm
+#endif
+
+namespace sage {
+
+Tournament::Tournament(const Settings& settings)
+  : m_settings(settings), m_players(), m_scores(), m_errors(0)
+{
+  if (m_settings.m_openings.empty())
+  {
+    Board board;
+    BoardUtil::initializeBoard(board);
+    m_settings.m_openings.push_back(board);
+  }
+
+  for (int i = 0; i < NUM_REASONS; ++i)
+  {
+    m_reasons[i].store(0);
+  }
+}
+
+Tournament::~Tournament()
+{
+
+}
+
+int Tournament::addPlayer(const std::string& name,
+                          const PolicyFactory& factory)
+{
+  Player player;
+  player.m_name = name;
+  player.m_factory = &factory;
+  m_players.push_back(player);
+  return getNumPlayers() - 1;
+}
+
+int Tournament::getNumGames() const
+{
+  int players = getNumPlayers();
+  int pairings = ((m_settings.m_schedule == SCHEDULE_gauntlet)
+                  ? (players - 1)
+                  : (players * (players - 1) / 2));
+  return ((pairings > 0) ? (pairings * m_settings.m_games) : 0);
+}
+
+void Tournament::run(ThreadPool& pool)
+{
+  m_scores.reset(new Score[m_players.size()]);
+  for (int i = 0; i < NUM_REASONS; ++i)
+  {
+    m_reasons[i].store(0);
+  }
+  m_errors.store(0);
+
+  std::vector<Pairing> pairings;
+  buildSchedule(pairings);
+
+  ThreadPool::TaskGroup group;
+  for (std::vector<Pairing>::const_iterator iter = pairings.begin();
+       iter != pairings.end();
+       ++iter)
+  {
+    Pairing pairing = *iter;
+    pool.submit(group, [this, pairing] {
+        playGame(pairing);
+      });
+  }
+  pool.wait(group);
+}
+
+Tournament::Standing Tournament::getStanding(int player) const
+{
+  Standing standing = { 0, 0, 0 };
+  if (m_scores)
+  {
+    const Score& score = m_scores[player];
+    standing.m_wins = score.m_wins.load(std::memory_order_relaxed);
+    standing.m_draws = score.m_draws.load(std::memory_order_relaxed);
+    standing.m_losses = score.m_losses.load(std::memory_order_relaxed);
+  }
+  return standing;
+}
+
+void Tournament::buildSchedule(std::vector<Pairing>& pairings) const
+{
+  int players = getNumPlayers();
+  int openings = static_cast<int>(m_settings.m_openings.size());
+  int last = ((m_settings.m_schedule == SCHEDULE_gauntlet)
+              ? std::min(players, 1) : players);
+
+  pairings.clear();
+  for (int first = 0; first < last; ++first)
+  {
+    for (int second = first + 1; second < players; ++second)
+    {
+      for (int game = 0; game < m_settings.m_games; ++game)
+      {
+        // colors alternate; swapped pairs repeat each opening once
+        Pairing pairing;
+        pairing.m_white = ((game & 1) ? second : first);
+        pairing.m_black = ((game & 1) ? first : second);
+        pairing.m_opening = ((m_settings.m_colorSwappedPairs
+                              ? (game / 2) : game) % openings);
+        pairing.m_index = static_cast<int>(pairings.size());
+        pairings.push_back(pairing);
+      }
+    }
+  }
+}
+
+void Tournament::playGame(const Pairing& pairing)
+{
+  // pool tasks must not throw, so any failure is only counted
+  try
+  {
+    // two seeds per game, one for each color
+    uint64_t seed = 2 * static_cast<uint64_t>(pairing.m_index);
+    std::unique_ptr<Policy> white(
+      m_players[pairing.m_white].m_factory->create(
+        Random::deriveSeed(m_settings.m_seed, seed)));
+    std::unique_ptr<Policy> black(
+      m_players[pairing.m_black].m_factory->create(
+        Random::deriveSeed(m_settings.m_seed, seed + 1)));
+
+    Engine engine(*white, *black, m_settings.m_openings[pairing.m_opening],
+                  m_settings.m_adjudication);
+    if (m_settings.m_eventSink)
+    {
+      engine.setEventSink(*m_settings.m_eventSink, pairing.m_index);
+    }
+    engine.run();
+
+    const Game& game = engine.getGame();
+    Score& whiteScore = m_scores[pairing.m_white];
+    Score& blackScore = m_scores[pairing.m_black];
+    switch (game.getState())
+    {
+    case STATE_whiteWon:
+      whiteScore.m_wins.fetch_add(1, std::memory_order_relaxed);
+      blackScore.m_losses.fetch_add(1, std::memory_order_relaxed);
+      break;
+    case STATE_blackWon:
+      whiteScore.m_losses.fetch_add(1, std::memory_order_relaxed);
+      blackScore.m_wins.fetch_add(1, std::memory_order_relaxed);
+      break;
+    default:
+      whiteScore.m_draws.fetch_add(1, std::memory_order_relaxed);
+      blackScore.m_draws.fetch_add(1, std::memory_order_relaxed);
+      break;
+    }
+
+    m_reasons[game.getReason()].fetch_add(1, std::memory_order_relaxed);
+  }
+  catch (const std::exception&)
+  {
+    m_errors.fetch_add(1, std::memory_order_relaxed);
+  }
+}
+
+} // namespace sage
@@ -0,0 +1,273 @@
+#ifndef INCLUDED_sage_Tournament_h
+#define INCLUDED_sage_Tournament_h
+
+#ifndef INCLUDED_sage_Board_h
+#include "sage/Board.h"
+#endif
+
+#ifndef INCLUDED_sage_Engine_h
+#include "sage/Engine.h"
+#endif
+
+#ifndef INCLUDED_sage_GameEvent_h
+#include "sage/GameEvent.h"
+#endif
+
+#ifndef INCLUDED_sage_PolicyFactory_h
+#include "sage/PolicyFactory.h"
+#endif
+
+#ifndef INCLUDED_sage_State_h
+#include "sage/State.h"
+#endif
+
+#ifndef INCLUDED_sage_ThreadPool_h
+#include "sage/ThreadPool.h"
+#endif
+
+#ifndef INCLUDED_std_atomic
+#include <atomic>
+#define INCLUDED_std_atomic
+#endif
+
+#ifndef INCLUDED_std_memory
+#include <memory>
+#define INCLUDED_std_memory
+#endif
+
+#ifndef INCLUDED_std_string
+#include <string>
+#define INCLUDED_std_string
+#endif
+
+#ifndef INCLUDED_std_vector
+#include <vector>
+#endif
+
+namespace sage {
+
+/*!
+  \brief Plays many games between a set of policies in parallel
+
+  Players are added with a name and a PolicyFactory; every game gets fresh
+  policies from the factories. The schedule decides who plays whom:
+
+  - Round robin: every player meets every other player.
+  - Gauntlet: the first player meets every other player.
+
+  Each pairing plays a fixed number of games, alternating colors. With
+  color-swapped pairs, consecutive games share a starting position, so
+  neither player profits from a lopsided opening.
+
+  run() submits one task per game to a ThreadPool, whose idle workers
+  steal queued games from busy ones. Results are added to per-player
+  atomic counters, so finished games never wait on each other.
+
+  Every game's policies are seeded from the master seed, the game's place
+  in the schedule and the color played. Which thread plays a game does not
+  matter, so a tournament repeated with the same seed gives the same
+  results.
+*/
+class Tournament
+{
+ public:
+
+  //! Ways of pairing the players
+  enum Schedule
+  {
+    SCHEDULE_roundRobin, //!< Every player against every other
+    SCHEDULE_gauntlet    //!< The first player against every other
+  };
+
+  //! How the tournament is played
+  struct Settings
+  {
+    /*!
+      \brief Default constructor: a round robin of color-swapped pairs
+      from the standard starting position
+    */
+    Settings()
+      : m_schedule(SCHEDULE_roundRobin), m_games(2),
+      m_colorSwappedPairs(true), m_openings(), m_adjudication(), m_seed(0),
+      m_eventSink(0)
+    {
+      ;
+    }
+
+    //! Who plays whom
+    Schedule m_schedule;
+
+    //! Games played by each pairing
+    int m_games;
+
+    //! Whether consecutive games of a pairing share a starting position
+    bool m_colorSwappedPairs;
+
+    //! Starting positions, used in turn; the standard one if empty
+    std::vector<Board> m_openings;
+
+    //! Rules for ending games early. The evaluator, if any, is shared by
+    //! all games and must be safe to call from several threads at once
+    Engine::Adjudication m_adjudication;
+
+    //! Master seed from which the seed of every game is derived
+    uint64_t m_seed;
+
+    //! Receives the events of every game, with the game's place in the
+    //! schedule as its id; 0 for none. It must be thread-safe.
+    GameEventSink* m_eventSink;
+  };
+
+  //! A player's results
+  struct Standing
+  {
+    int m_wins;   //!< Games won
+    int m_draws;  //!< Games drawn
+    int m_losses; //!< Games lost
+
+    /*!
+      \brief Returns the score, counting a draw as half a win
+    */
+    double getPoints() const { return m_wins + 0.5 * m_draws; }
+  };
+
+  /*!
+    \brief Constructor: builds a tournament without players
+    \param settings How the tournament is played
+  */
+  explicit Tournament(const Settings& settings);
+
+  /*!
+    \brief Destructor
+  */
+  virtual ~Tournament();
+
+  /*!
+    \brief Adds a player
+    \param name Name reported with the results
+    \param factory Creates the player's policies; it must outlive run()
+    \return The index of the player
+  */
+  int addPlayer(const std::string& name, const PolicyFactory& factory);
+
+  /*!
+    \brief Returns the number of players
+  */
+  int getNumPlayers() const { return static_cast<int>(m_players.size()); }
+
+  /*!
+    \brief Returns the name of a player
+    \param player The player index [0, getNumPlayers() - 1]
+  */
+  const std::string& getPlayerName(int player) const
+  {
+    return m_players[player].m_name;
+  }
+
+  /*!
+    \brief Returns the number of games the schedule calls for
+  */
+  int getNumGames() const;
+
+  /*!
+    \brief Plays every scheduled game
+    \param pool The threads to play on
+
+    Results from any earlier run are cleared first. Games that throw (e.g.
+    because a policy chose a move that does not exist) are counted by
+    getErrorCount() and not scored.
+  */
+  void run(ThreadPool& pool);
+
+  /*!
+    \brief Returns a player's results
+    \param player The player index [0, getNumPlayers() - 1]
+  */
+  Standing getStanding(int player) const;
+
+  /*!
+    \brief Returns how many games ended for the given reason
+  */
+  int getReasonCount(Reason reason) const
+  {
+    return m_reasons[reason].load(std::memory_order_relaxed);
+  }
+
+  /*!
+    \brief Returns how many games were abandoned because of an error
+  */
+  int getErrorCount() const
+  {
+    return m_errors.load(std::memory_order_relaxed);
+  }
+
+ private:
+  // Default constructor not defined
+  Tournament();
+
+  //! Constants used by the tournament
+  enum Constant
+  {
+    NUM_REASONS = REASON_external + 1 //!< Size of the reason counters
+  };
+
+  //! A participant
+  struct Player
+  {
+    std::string m_name;               //!< Name reported with the results
+    const PolicyFactory* m_factory;   //!< Creates the player's policies
+  };
+
+  //! One scheduled game
+  struct Pairing
+  {
+    int m_white;   //!< Player index of white
+    int m_black;   //!< Player index of black
+    int m_opening; //!< Index of the starting position
+    int m_index;   //!< Position of the game in the schedule
+  };
+
+  //! Result counters of one player, updated by many threads
+  struct Score
+  {
+    Score()
+      : m_wins(0), m_draws(0), m_losses(0)
+    {
+      ;
+    }
+
+    std::atomic<int> m_wins;   //!< Games won
+    std::atomic<int> m_draws;  //!< Games drawn
+    std::atomic<int> m_losses; //!< Games lost
+  };
+
+  /*!
+    \brief Lists every game the schedule calls for
+    \param pairings [out] The games, in the order they are submitted
+  */
+  void buildSchedule(std::vector<Pairing>& pairings) const;
+
+  /*!
+    \brief Plays one game and records its result; run as a pool task
+  */
+  void playGame(const Pairing& pairing);
+
+  //! How the tournament is played
+  Settings m_settings;
+
+  //! The participants
+  std::vector<Player> m_players;
+
+  //! Results, one per player
+  std::unique_ptr<Score[]> m_scores;
+
+  //! Number of games that ended for each Reason
+  std::atomic<int> m_reasons[NUM_REASONS];
+
+  //! Number of games abandoned because of an error
+  std::atomic<int> m_errors;
+};
+
+} // namespace sage
+
+#endif
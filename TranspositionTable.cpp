@@ -0,0 +1,208 @@
+#include "sage/TranspositionTable.h"
+
+#ifndef INCLUDED_sage_Exception_h
+#include "sage/Exception.h"
+#endif
+
+#ifndef INCLUDED_std_new
+#include <new>
+#define INCLUDED_std_new
+#endif
+
+#ifndef INCLUDED_std_stdlib
+#include <stdlib.h>
+#define INCLUDED_std_stdlib
+#endif
+
+#ifndef INCLUDED_std_sys_mman
+#include <sys/mman.h>
+#define INCLUDED_std_sys_mman
+#endif
+
+namespace sage {
+
+namespace {
+
+  //! Depth an entry is worth less for each search it is older
+  const int AGE_WEIGHT = 8;
+
+  //! Depth by which an entry for the same position must be deeper to be
+  //! kept over a new, inexact result
+  const int KEEP_MARGIN = 3;
+
+  //! Buckets sampled by getUsage()
+  const size_t USAGE_SAMPLE = 250;
+
+} // anonymous namespace
+
+TranspositionTable::TranspositionTable(size_t megabytes, bool hugePages)
+  : m_buckets(0), m_mask(0), m_generation(0)
+{
+  const size_t bytes = megabytes << 20;
+  size_t count = 1;
+  while ((count * 2 * sizeof(Bucket)) <= bytes)
+  {
+    count <<= 1;
+  }
+
+  const size_t size = count * sizeof(Bucket);
+  size_t alignment = BUCKET_SIZE;
+
+#ifdef MADV_HUGEPAGE
+  if (hugePages && (size >= HUGE_PAGE_SIZE))
+  {
+    alignment = HUGE_PAGE_SIZE;
+  }
+#endif
+
+  void* memory = 0;
+  if (posix_memalign(&memory, alignment, size) != 0)
+  {
+    throw Exception("TranspositionTable: cannot allocate the table");
+  }
+
+#ifdef MADV_HUGEPAGE
+  if (alignment == HUGE_PAGE_SIZE)
+  {
+    // only a hint; the table works the same without huge pages
+    madvise(memory, size, MADV_HUGEPAGE);
+  }
+#endif
+
+  m_buckets = static_cast<Bucket*>(memory);
+  m_mask = count - 1;
+  for (size_t i = 0; i < count; ++i)
+  {
+    new (&m_buckets[i]) Bucket;
+  }
+
+  clear();
+}
+
+TranspositionTable::~TranspositionTable()
+{
+  free(m_buckets);
+}
+
+void TranspositionTable::clear()
+{
+  for (size_t i = 0; i <= m_mask; ++i)
+  {
+    for (int j = 0; j < BUCKET_ENTRIES; ++j)
+    {
+      m_buckets[i].m_slots[j].m_key.store(0, std::memory_order_relaxed);
+      m_buckets[i].m_slots[j].m_data.store(0, std::memory_order_relaxed);
+    }
+  }
+
+  m_generation.store(0, std::memory_order_relaxed);
+}
+
+bool TranspositionTable::probe(HashKey hash, Entry& entry) const
+{
+  const Bucket& bucket = m_buckets[hash & m_mask];
+
+  for (int i = 0; i < BUCKET_ENTRIES; ++i)
+  {
+    uint64_t data = bucket.m_slots[i].m_data.load(std::memory_order_relaxed);
+    uint64_t key = bucket.m_slots[i].m_key.load(std::memory_order_relaxed);
+
+    if ((key ^ data) == hash)
+    {
+      entry = Entry(data);
+      return true;
+    }
+  }
+
+  return false;
+}
+
+void TranspositionTable::store(HashKey hash, PackedMove move, int score,
+                               int depth, Bound bound)
+{
+  Bucket& bucket = m_buckets[hash & m_mask];
+  const int generation = m_generation.load(std::memory_order_relaxed);
+
+  if (depth > MAX_DEPTH)
+  {
+    depth = MAX_DEPTH;
+  }
+
+  // prefer the position's own entry, then an empty one, then the one worth
+  // least
+  Slot* target = 0;
+  int worst = 0;
+  for (int i = 0; i < BUCKET_ENTRIES; ++i)
+  {
+    Slot& slot = bucket.m_slots[i];
+    Entry entry(slot.m_data.load(std::memory_order_relaxed));
+    uint64_t key = slot.m_key.load(std::memory_order_relaxed);
+
+    if ((key ^ entry.getData()) == hash)
+    {
+      if ((move.getData() == 0) && entry.hasMove())
+      {
+        move = entry.getMove();
+      }
+
+      // a deeper result from this search is worth more than a bound
+      if ((bound != BOUND_exact) && (entry.getGeneration() == generation)
+          && (entry.getDepth() > depth + KEEP_MARGIN))
+      {
+        return;
+      }
+
+      target = &slot;
+      break;
+    }
+
+    if (entry.getBound() == BOUND_none)
+    {
+      target = &slot;
+      break;
+    }
+
+    int age = (generation - entry.getGeneration()) & (NUM_GENERATIONS - 1);
+    int value = entry.getDepth() - (AGE_WEIGHT * age);
+    if (!target || (value < worst))
+    {
+      target = &slot;
+      worst = value;
+    }
+  }
+
+  uint64_t data = (static_cast<uint64_t>(move.getData())
+                   | (static_cast<uint64_t>(static_cast<uint16_t>(score))
+                      << 16)
+                   | (static_cast<uint64_t>(depth) << 32)
+                   | (static_cast<uint64_t>(bound) << 40)
+                   | (static_cast<uint64_t>(generation) << 42));
+
+  target->m_key.store(hash ^ data, std::memory_order_relaxed);
+  target->m_data.store(data, std::memory_order_relaxed);
+}
+
+int TranspositionTable::getUsage() const
+{
+  const size_t count = ((m_mask < USAGE_SAMPLE) ? (m_mask + 1) : USAGE_SAMPLE);
+  const int generation = m_generation.load(std::memory_order_relaxed);
+  size_t used = 0;
+
+  for (size_t i = 0; i < count; ++i)
+  {
+    for (int j = 0; j < BUCKET_ENTRIES; ++j)
+    {
+      Entry entry(m_buckets[i].m_slots[j].m_data.load(
+                    std::memory_order_relaxed));
+      if ((entry.getBound() != BOUND_none)
+          && (entry.getGeneration() == generation))
+      {
+        ++used;
+      }
+    }
+  }
+
+  return static_cast<int>((used * 1000) / (count * BUCKET_ENTRIES));
+}
+
+} // namespace sage
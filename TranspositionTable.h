@@ -0,0 +1,257 @@
+#ifndef INCLUDED_sage_TranspositionTable_h
+#define INCLUDED_sage_TranspositionTable_h
+
+#ifndef INCLUDED_sage_PackedMove_h
+#include "sage/PackedMove.h"
+#endif
+
+#ifndef INCLUDED_sage_Zobrist_h
+#include "sage/Zobrist.h"
+#endif
+
+#ifndef INCLUDED_std_atomic
+#include <atomic>
+#define INCLUDED_std_atomic
+#endif
+
+#ifndef INCLUDED_std_cstddef
+#include <cstddef>
+#define INCLUDED_std_cstddef
+#endif
+
+#ifndef INCLUDED_std_stdint
+#include <stdint.h>
+#define INCLUDED_std_stdint
+#endif
+
+namespace sage {
+
+/*!
+  \brief Fixed size cache of search results, keyed by position hash
+
+  The table is an array of buckets, each the size of a cache line and
+  holding four entries, so a probe costs one memory access. Call
+  prefetch() with the hash of a position as soon as the move leading to
+  it is made; the line is then usually in cache by the time the position
+  is probed.
+
+  Any number of threads may probe and store at once without locks. Each
+  entry is two 64 bit words, the data and the hash XORed with the data. A
+  reader only accepts an entry if the two words give back the hash it is
+  looking for, so an entry torn by two writers at once reads as a miss
+  rather than as wrong data.
+
+  When a bucket is full, the entry replaced is the one with the least
+  depth, counting entries from earlier searches as much shallower. Call
+  newSearch() before each search to age the existing entries.
+
+  Scores are stored as they are given. Searches that share a table must
+  agree on what they mean, e.g. by using the same evaluator.
+*/
+class TranspositionTable
+{
+ public:
+
+  //! How a stored score relates to the true score
+  enum Bound
+  {
+    BOUND_none = 0, //!< No score is stored
+    BOUND_upper,    //!< The true score is at most the stored one
+    BOUND_lower,    //!< The true score is at least the stored one
+    BOUND_exact     //!< The stored score is the true score
+  };
+
+  //! Constants used by the table
+  enum Constant
+  {
+    BUCKET_SIZE = 64,          //!< Bytes per bucket
+    BUCKET_ENTRIES = 4,        //!< Entries per bucket
+    MAX_DEPTH = 0xff,          //!< Largest depth that can be stored
+    NUM_GENERATIONS = 0x40,    //!< Generations before the count wraps
+    HUGE_PAGE_SIZE = 0x200000  //!< Alignment used for huge pages
+  };
+
+  /*!
+    \brief One search result, as read back from the table
+  */
+  class Entry
+  {
+   public:
+
+    /*!
+      \brief Default constructor: an empty entry
+    */
+    Entry()
+      : m_data(0)
+    {
+      ;
+    }
+
+    /*!
+      \brief Constructor
+      \param data The packed entry
+    */
+    explicit Entry(uint64_t data)
+      : m_data(data)
+    {
+      ;
+    }
+
+    /*!
+      \brief Returns the best move found; only valid if hasMove()
+    */
+    PackedMove getMove() const
+    {
+      return PackedMove(m_data & 0x3f, (m_data >> 6) & 0x3f,
+                        static_cast<PackedMove::Flag>((m_data >> 12) & 0xf));
+    }
+
+    /*!
+      \brief Returns whether a best move is stored
+    */
+    bool hasMove() const { return (m_data & 0xffff) != 0; }
+
+    /*!
+      \brief Returns the score
+    */
+    int getScore() const { return static_cast<int16_t>(m_data >> 16); }
+
+    /*!
+      \brief Returns the depth the score was searched to
+    */
+    int getDepth() const { return static_cast<int>((m_data >> 32) & 0xff); }
+
+    /*!
+      \brief Returns how the score relates to the true score
+    */
+    Bound getBound() const
+    {
+      return static_cast<Bound>((m_data >> 40) & 0x3);
+    }
+
+    /*!
+      \brief Returns the search generation the entry was stored in
+    */
+    int getGeneration() const
+    {
+      return static_cast<int>((m_data >> 42) & (NUM_GENERATIONS - 1));
+    }
+
+    /*!
+      \brief Returns the packed entry
+    */
+    uint64_t getData() const { return m_data; }
+
+   private:
+    //! Move in bits 0-15, score 16-31, depth 32-39, bound 40-41 and
+    //! generation 42-47
+    uint64_t m_data;
+  };
+
+  /*!
+    \brief Constructor: allocates and clears the table
+    \param megabytes Size of the table; rounded down to a power of two
+    buckets, and at least one bucket
+    \param hugePages Whether to ask the system to back the table with huge
+    pages, which saves TLB misses on large tables. This is only a hint;
+    it is ignored where not supported.
+
+    Throws an Exception if the memory cannot be allocated.
+  */
+  explicit TranspositionTable(size_t megabytes, bool hugePages = false);
+
+  /*!
+    \brief Destructor: frees the table
+  */
+  virtual ~TranspositionTable();
+
+  /*!
+    \brief Empties the table; no search may be using it
+  */
+  void clear();
+
+  /*!
+    \brief Starts a new search generation, aging the existing entries
+  */
+  void newSearch()
+  {
+    m_generation.store((m_generation.load(std::memory_order_relaxed) + 1)
+                       & (NUM_GENERATIONS - 1),
+                       std::memory_order_relaxed);
+  }
+
+  /*!
+    \brief Starts loading the bucket for a position into cache
+    \param hash The hash of the position
+  */
+  void prefetch(HashKey hash) const
+  {
+    __builtin_prefetch(&m_buckets[hash & m_mask]);
+  }
+
+  /*!
+    \brief Looks up a position
+    \param hash The hash of the position
+    \param entry [out] The entry found
+    \retval true If the position was found
+    \retval false If not; entry is left alone
+  */
+  bool probe(HashKey hash, Entry& entry) const;
+
+  /*!
+    \brief Stores a search result
+    \param hash The hash of the position
+    \param move The best move found; PackedMove() with all bits zero if
+    none, in which case a move already stored for the position is kept
+    \param score The score, which must fit in 16 bits
+    \param depth The depth searched to; capped at MAX_DEPTH
+    \param bound How the score relates to the true score
+  */
+  void store(HashKey hash, PackedMove move, int score, int depth,
+             Bound bound);
+
+  /*!
+    \brief Returns the number of entries the table holds
+  */
+  size_t getNumEntries() const { return (m_mask + 1) * BUCKET_ENTRIES; }
+
+  /*!
+    \brief Estimates how full the table is with entries of this search
+    \return Entries per thousand, from a sample of the buckets
+  */
+  int getUsage() const;
+
+ private:
+  // Default constructor not defined
+  TranspositionTable();
+
+  // Copy constructor and assignment not defined
+  TranspositionTable(const TranspositionTable&);
+  TranspositionTable& operator=(const TranspositionTable&);
+
+  //! One entry; the key word is the hash XORed with the data word
+  struct Slot
+  {
+    std::atomic<uint64_t> m_key;  //!< Hash XOR data
+    std::atomic<uint64_t> m_data; //!< Packed Entry
+  };
+
+  //! Entries that share a cache line
+  struct alignas(BUCKET_SIZE) Bucket
+  {
+    Slot m_slots[BUCKET_ENTRIES]; //!< The entries
+  };
+
+  //! The buckets
+  Bucket* m_buckets;
+
+  //! Number of buckets minus one
+  size_t m_mask;
+
+  //! Generation of the current search
+  std::atomic<int> m_generation;
+};
+
+} // namespace sage
+
+#endif
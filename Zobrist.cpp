@@ -0,0 +1,109 @@
+#include "sage/Zobrist.h"
+
+#ifndef INCLUDED_sage_Board_h
+#include "sage/Board.h"
+#endif
+
+namespace sage {
+
+HashKey Zobrist::s_pieceKeys[Piece::NUM_TYPES][BitboardUtil::NUM_SQUARES];
+HashKey Zobrist::s_stateKeys[Zobrist::NUM_STATES];
+
+namespace {
+
+  /*!
+    \brief SplitMix64 generator used to fill the key tables
+
+    The fixed seed keeps the keys identical from run to run.
+  */
+  class KeyRandom
+  {
+   public:
+    KeyRandom(uint64_t seed)
+      : m_state(seed)
+    {
+      ;
+    }
+
+    HashKey next()
+    {
+      uint64_t z = (m_state += 0x9e3779b97f4a7c15ULL);
+      z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+      z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+      return z ^ (z >> 31);
+    }
+
+   private:
+    uint64_t m_state;
+  };
+
+  //! Builds the tables before main() runs
+  class ZobristInitializer
+  {
+   public:
+    ZobristInitializer()
+    {
+      Zobrist::initialize();
+    }
+  };
+
+  ZobristInitializer zobristInitializer;
+
+} // anonymous namespace
+
+void Zobrist::initialize()
+{
+  KeyRandom random(0x5a6e5a6e5a6e5a6eULL);
+
+  for (int i = 0; i < Piece::NUM_TYPES; ++i)
+  {
+    for (int square = 0; square < BitboardUtil::NUM_SQUARES; ++square)
+    {
+      s_pieceKeys[i][square] = random.next();
+    }
+  }
+
+  HashKey castleKeys[4];
+  for (int i = 0; i < 4; ++i)
+  {
+    castleKeys[i] = random.next();
+  }
+
+  HashKey enPassantKeys[Board::NUM_COLUMNS];
+  for (int i = 0; i < Board::NUM_COLUMNS; ++i)
+  {
+    enPassantKeys[i] = random.next();
+  }
+
+  HashKey blackTurnKey = random.next();
+
+  // combine the individual keys for every state word
+  for (uint32_t state = 0; state < NUM_STATES; ++state)
+  {
+    HashKey key = 0;
+
+    for (int i = 0; i < 4; ++i)
+    {
+      if (state & (Board::FLAG_whiteKingCastle << i))
+      {
+        key ^= castleKeys[i];
+      }
+    }
+
+    int enPassant = static_cast<int>((state & Board::FLAG_enPassantMask)
+                                     >> Board::FLAG_enPassantShift);
+    if ((enPassant > 0) && (enPassant <= Board::NUM_COLUMNS))
+    {
+      key ^= enPassantKeys[enPassant - 1];
+    }
+
+    if (state & Board::FLAG_blackTurn)
+    {
+      key ^= blackTurnKey;
+    }
+
+    s_stateKeys[state] = key;
+  }
+}
+
+} // namespace sage
@@ -0,0 +1,89 @@
+#ifndef INCLUDED_sage_Zobrist_h
+#define INCLUDED_sage_Zobrist_h
+
+#ifndef INCLUDED_sage_Piece_h
+#include "sage/Piece.h"
+#endif
+
+#ifndef INCLUDED_sage_Bitboard_h
+#include "sage/Bitboard.h"
+#endif
+
+#ifndef INCLUDED_std_stdint
+#include <stdint.h>
+#define INCLUDED_std_stdint
+#endif
+
+namespace sage {
+
+//! A 64 bit position hash
+typedef uint64_t HashKey;
+
+/*!
+  \brief Random keys for Zobrist hashing of board positions
+
+  A position's key is the XOR of one key per piece on the board (indexed by
+  Piece::getIndex() and square) and one key for the rest of the board
+  state. Since XOR is its own inverse, moving a piece only takes two XORs
+  to update the key.
+
+  The state key covers castling rights, the en passant column and the side
+  to move. Rather than XORing in separate keys for each of these, the
+  combined key for every possible Board state word is precomputed, so the
+  state is hashed with a single table lookup.
+
+  The keys are generated from a fixed seed, so they are the same in every
+  run of the program and hashes can be stored and compared across runs.
+
+  All methods are declared static so you don't have to instantiate this
+  class.
+*/
+class Zobrist
+{
+ public:
+
+  //! Constants defined by the key tables
+  enum Constant
+  {
+    NUM_STATES = 0x200 //!< Number of state words that affect the hash
+  };
+
+  /*!
+    \brief Returns the key for a piece on a square
+    \param index Piece::getIndex() of the piece type
+    \param square The square index
+  */
+  static HashKey getPieceKey(int index, int square)
+  {
+    return s_pieceKeys[index][square];
+  }
+
+  /*!
+    \brief Returns the key for a Board state word
+    \param state The packed state word; see Board::StateFlag. The
+    halfmove clock, above the low nine bits, is ignored.
+  */
+  static HashKey getStateKey(uint32_t state)
+  {
+    return s_stateKeys[state & (NUM_STATES - 1)];
+  }
+
+  /*!
+    \brief Builds the key tables
+
+    This is called automatically at program startup.
+  */
+  static void initialize();
+
+ private:
+
+  //! Piece keys, indexed by Piece::getIndex() and square
+  static HashKey s_pieceKeys[Piece::NUM_TYPES][BitboardUtil::NUM_SQUARES];
+
+  //! Combined castling, en passant and side to move keys by state word
+  static HashKey s_stateKeys[NUM_STATES];
+};
+
+} // namespace sage
+
+#endif